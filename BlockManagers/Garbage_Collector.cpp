@@ -0,0 +1,25 @@
+#include "../ssd.h"
+#include "../block_management.h"
+using namespace ssd;
+
+Garbage_Collector::~Garbage_Collector() {
+	if (policy_name == NULL || PRINT_LEVEL < 1) {
+		return;
+	}
+	printf("gc policy\t%s\n", policy_name);
+	printf("gc host writes\t%ld\n", num_host_writes);
+	printf("gc migration writes\t%ld\n", num_gc_writes);
+	printf("gc write amplification\t%f\n", num_host_writes == 0 ? 0.0 : (num_host_writes + num_gc_writes) / (double)num_host_writes);
+}
+
+void Garbage_Collector::count_write(Event const& event) {
+	event_type type = event.get_event_type();
+	if (event.get_noop() || event.get_address().valid < PAGE || (type != WRITE && type != COPY_BACK)) {
+		return;
+	}
+	if (type == COPY_BACK || event.is_garbage_collection_op()) {
+		num_gc_writes++;
+	} else {
+		num_host_writes++;
+	}
+}
@@ -0,0 +1,42 @@
+#include "../ssd.h"
+#include "../block_management.h"
+using namespace ssd;
+
+// age * (1 - u) / 2u. A block without valid pages is free to reclaim, and always comes first.
+double Garbage_Collector_Cost_Benefit::get_priority(long block_id) const {
+	int num_valid_pages = bucket_of_block[block_id];
+	if (num_valid_pages == 0) {
+		return numeric_limits<double>::infinity();
+	}
+	double u = num_valid_pages / (double)BLOCK_SIZE;
+	double age = current_time - time_of_last_change[block_id] + 1;
+	return age * (1 - u) / (2 * u);
+}
+
+// Looks at the oldest collectable block of every bucket, since it has the highest score among the blocks of its bucket
+Block* Garbage_Collector_Cost_Benefit::choose_gc_victim_in_lun(int lun) const {
+	double best_priority = 0;
+	Block* best_block = NULL;
+	vector<ulong> const& non_empty = non_empty_buckets[lun];
+	for (uint word = 0; word < non_empty.size(); word++) {
+		for (ulong bits = non_empty[word]; bits != 0; bits &= bits - 1) {
+			int num_valid_pages = word * 64 + __builtin_ctzl(bits);
+			if (num_valid_pages >= BLOCK_SIZE) {
+				return best_block;
+			}
+			for (long block_id = first_in_bucket[lun][num_valid_pages]; block_id != UNDEFINED; block_id = next_in_bucket[block_id]) {
+				Block* block = get_block(block_id);
+				if (!may_be_collected(block)) {
+					continue;
+				}
+				double priority = get_priority(block_id);
+				if (best_block == NULL || priority > best_priority) {
+					best_priority = priority;
+					best_block = block;
+				}
+				break;
+			}
+		}
+	}
+	return best_block;
+}
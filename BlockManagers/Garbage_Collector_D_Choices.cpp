@@ -0,0 +1,54 @@
+#include "../ssd.h"
+#include "../block_management.h"
+using namespace ssd;
+
+int Garbage_Collector_D_Choices::D = 8;
+
+Garbage_Collector_D_Choices::Garbage_Collector_D_Choices()
+	:  Garbage_Collector_Greedy(),
+	   candidates(SSD_SIZE * PACKAGE_SIZE),
+	   position_in_lun(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	   random_number_generator(43)
+{}
+
+Garbage_Collector_D_Choices::Garbage_Collector_D_Choices(Ssd* ssd, Block_manager_parent* bm)
+	:  Garbage_Collector_Greedy(ssd, bm, "d-choices"),
+	   candidates(SSD_SIZE * PACKAGE_SIZE),
+	   position_in_lun(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	   random_number_generator(43)
+{}
+
+// Samples with replacement. If none of the sampled blocks can be collected, e.g. because they are still being written,
+// the greedy choice is taken instead, so garbage-collection is never cancelled for lack of a candidate when one exists.
+Block* Garbage_Collector_D_Choices::choose_gc_victim_in_lun(int lun) const {
+	vector<long> const& c = candidates[lun];
+	if (c.empty()) {
+		return NULL;
+	}
+	Block* best_block = NULL;
+	for (int i = 0; i < D; i++) {
+		long block_id = c[random_number_generator() % c.size()];
+		Block* block = get_block(block_id);
+		if (may_be_collected(block) && bucket_of_block[block_id] < BLOCK_SIZE &&
+				(best_block == NULL || block->get_pages_valid() < best_block->get_pages_valid())) {
+			best_block = block;
+		}
+	}
+	return best_block != NULL ? best_block : Garbage_Collector_Greedy::choose_gc_victim_in_lun(lun);
+}
+
+void Garbage_Collector_D_Choices::insert(long block_id, int lun, int num_valid_pages) {
+	Garbage_Collector_Greedy::insert(block_id, lun, num_valid_pages);
+	position_in_lun[block_id] = candidates[lun].size();
+	candidates[lun].push_back(block_id);
+}
+
+void Garbage_Collector_D_Choices::remove(long block_id, int lun) {
+	Garbage_Collector_Greedy::remove(block_id, lun);
+	vector<long>& c = candidates[lun];
+	long last = c.back();
+	c[position_in_lun[block_id]] = last;
+	position_in_lun[last] = position_in_lun[block_id];
+	c.pop_back();
+	position_in_lun[block_id] = UNDEFINED;
+}
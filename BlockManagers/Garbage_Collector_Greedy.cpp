@@ -4,53 +4,151 @@ using namespace ssd;
 
 Garbage_Collector_Greedy::Garbage_Collector_Greedy()
 	:  Garbage_Collector(),
-	   gc_candidates(SSD_SIZE, vector<set<long> >(PACKAGE_SIZE, set<long>()))
+	   first_in_bucket(SSD_SIZE * PACKAGE_SIZE, vector<long>(BLOCK_SIZE + 1, UNDEFINED)),
+	   last_in_bucket(SSD_SIZE * PACKAGE_SIZE, vector<long>(BLOCK_SIZE + 1, UNDEFINED)),
+	   non_empty_buckets(SSD_SIZE * PACKAGE_SIZE, vector<ulong>(BLOCK_SIZE / 64 + 1, 0)),
+	   num_candidates(SSD_SIZE * PACKAGE_SIZE, 0),
+	   bucket_of_block(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	   next_in_bucket(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	   previous_in_bucket(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	   time_of_last_change(NUMBER_OF_ADDRESSABLE_BLOCKS(), 0),
+	   current_time(0)
 {}
 
-Garbage_Collector_Greedy::Garbage_Collector_Greedy(Ssd* ssd, Block_manager_parent* bm)
-	:  Garbage_Collector(ssd, bm),
-	   gc_candidates(SSD_SIZE, vector<set<long> >(PACKAGE_SIZE, set<long>()))
+Garbage_Collector_Greedy::Garbage_Collector_Greedy(Ssd* ssd, Block_manager_parent* bm, const char* policy_name)
+	:  Garbage_Collector(ssd, bm, policy_name),
+	   first_in_bucket(SSD_SIZE * PACKAGE_SIZE, vector<long>(BLOCK_SIZE + 1, UNDEFINED)),
+	   last_in_bucket(SSD_SIZE * PACKAGE_SIZE, vector<long>(BLOCK_SIZE + 1, UNDEFINED)),
+	   non_empty_buckets(SSD_SIZE * PACKAGE_SIZE, vector<ulong>(BLOCK_SIZE / 64 + 1, 0)),
+	   num_candidates(SSD_SIZE * PACKAGE_SIZE, 0),
+	   bucket_of_block(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	   next_in_bucket(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	   previous_in_bucket(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	   time_of_last_change(NUMBER_OF_ADDRESSABLE_BLOCKS(), 0),
+	   current_time(0)
 {}
 
 void Garbage_Collector_Greedy::commit_choice_of_victim(Address const& phys_address, double time) {
-	gc_candidates[phys_address.package][phys_address.die].erase(phys_address.get_linear_address());
+	long block_id = phys_address.get_block_id();
+	if (bucket_of_block[block_id] != UNDEFINED) {
+		remove(block_id, get_lun(phys_address));
+	}
+}
+
+Block* Garbage_Collector_Greedy::get_block(long block_id) const {
+	Address a = Address(block_id * BLOCK_SIZE, BLOCK);
+	return ssd->get_package(a.package)->get_die(a.die)->get_plane(a.plane)->get_block(a.block);
 }
 
-vector<long> Garbage_Collector_Greedy::get_relevant_gc_candidates(int package_id, int die_id, int klass) const {
-	vector<long > candidates;
+Block* Garbage_Collector_Greedy::choose_gc_victim(int package_id, int die_id, int klass) const {
+	double best_priority = 0;
+	Block* best_block = NULL;
 	int package = package_id == -1 ? 0 : package_id;
 	int num_packages = package_id == -1 ? SSD_SIZE : package_id + 1;
 	for (; package < num_packages; package++) {
 		int die = die_id == -1 ? 0 : die_id;
 		int num_dies = die_id == -1 ? PACKAGE_SIZE : die_id + 1;
 		for (; die < num_dies; die++) {
-			for (auto i : gc_candidates[package][die]) {
-				candidates.push_back(i);
+			Block* block = choose_gc_victim_in_lun(package * PACKAGE_SIZE + die);
+			if (block == NULL) {
+				continue;
+			}
+			double priority = get_priority(Address(block->get_physical_address(), BLOCK).get_block_id());
+			if (best_block == NULL || priority > best_priority) {
+				best_priority = priority;
+				best_block = block;
 			}
 		}
 	}
-	return candidates;
+	return best_block;
 }
 
-Block* Garbage_Collector_Greedy::choose_gc_victim(int package_id, int die_id, int klass) const {
-	vector<long> candidates = get_relevant_gc_candidates(package_id, die_id, klass);
-	uint min_valid_pages = BLOCK_SIZE;
-	Block* best_block = NULL;
-	for (auto physical_address : candidates) {
-		Address a = Address(physical_address, BLOCK);
-		Block* block = ssd->get_package(a.package)->get_die(a.die)->get_plane(a.plane)->get_block(a.block);
-		if (block->get_pages_valid() < min_valid_pages && (block->get_state() == ACTIVE || block->get_state() == INACTIVE)) {
-			min_valid_pages = block->get_pages_valid();
-			best_block = block;
-			assert(min_valid_pages < BLOCK_SIZE);
+double Garbage_Collector_Greedy::get_priority(long block_id) const {
+	return -bucket_of_block[block_id];
+}
+
+// Blocks that are still being written cannot be garbage-collected, so they are skipped. There are few of them in each LUN.
+Block* Garbage_Collector_Greedy::choose_gc_victim_in_lun(int lun) const {
+	vector<ulong> const& non_empty = non_empty_buckets[lun];
+	for (uint word = 0; word < non_empty.size(); word++) {
+		for (ulong bits = non_empty[word]; bits != 0; bits &= bits - 1) {
+			int num_valid_pages = word * 64 + __builtin_ctzl(bits);
+			if (num_valid_pages >= BLOCK_SIZE) {
+				return NULL;
+			}
+			for (long block_id = first_in_bucket[lun][num_valid_pages]; block_id != UNDEFINED; block_id = next_in_bucket[block_id]) {
+				Block* block = get_block(block_id);
+				if (may_be_collected(block)) {
+					return block;
+				}
+			}
 		}
 	}
+	return NULL;
+}
 
-	return best_block;
+void Garbage_Collector_Greedy::insert(long block_id, int lun, int num_valid_pages) {
+	link(block_id, lun, num_valid_pages);
+	num_candidates[lun]++;
 }
 
+void Garbage_Collector_Greedy::remove(long block_id, int lun) {
+	unlink(block_id, lun);
+	num_candidates[lun]--;
+}
+
+// Appends the block to its bucket, whose blocks are then ordered by the time they last changed
+void Garbage_Collector_Greedy::link(long block_id, int lun, int num_valid_pages) {
+	long last = last_in_bucket[lun][num_valid_pages];
+	bucket_of_block[block_id] = num_valid_pages;
+	previous_in_bucket[block_id] = last;
+	next_in_bucket[block_id] = UNDEFINED;
+	if (last == UNDEFINED) {
+		first_in_bucket[lun][num_valid_pages] = block_id;
+		non_empty_buckets[lun][num_valid_pages / 64] |= 1UL << (num_valid_pages % 64);
+	} else {
+		next_in_bucket[last] = block_id;
+	}
+	last_in_bucket[lun][num_valid_pages] = block_id;
+	time_of_last_change[block_id] = current_time;
+}
+
+void Garbage_Collector_Greedy::unlink(long block_id, int lun) {
+	int num_valid_pages = bucket_of_block[block_id];
+	long previous = previous_in_bucket[block_id];
+	long next = next_in_bucket[block_id];
+	if (previous == UNDEFINED) first_in_bucket[lun][num_valid_pages] = next;
+	else						next_in_bucket[previous] = next;
+	if (next == UNDEFINED)		last_in_bucket[lun][num_valid_pages] = previous;
+	else						previous_in_bucket[next] = previous;
+	if (first_in_bucket[lun][num_valid_pages] == UNDEFINED) {
+		non_empty_buckets[lun][num_valid_pages / 64] &= ~(1UL << (num_valid_pages % 64));
+	}
+	bucket_of_block[block_id] = UNDEFINED;
+	previous_in_bucket[block_id] = UNDEFINED;
+	next_in_bucket[block_id] = UNDEFINED;
+}
+
+// Moves a candidate to the bucket of its current number of valid pages
+void Garbage_Collector_Greedy::update(Address const& a) {
+	long block_id = a.get_block_id();
+	if (bucket_of_block[block_id] == UNDEFINED) {
+		return;
+	}
+	unlink(block_id, get_lun(a));
+	link(block_id, get_lun(a), get_block(block_id)->get_pages_valid());
+}
+
+// Pages are invalidated by writes and trims, and become valid when written, so candidates are re-bucketed on both.
+// Either kind of invalidation makes a block a candidate, so blocks whose pages are only ever trimmed are reclaimed too.
 void Garbage_Collector_Greedy::register_event_completion(Event const& event) {
-	if (event.get_event_type() != WRITE) {
+	count_write(event);
+	current_time = max(current_time, event.get_current_time());
+	event_type type = event.get_event_type();
+	if ((type == WRITE || type == COPY_BACK || type == ERASE) && !event.get_noop() && event.get_address().valid >= BLOCK) {
+		update(event.get_address());
+	}
+	if (type != WRITE && type != TRIM) {
 		return;
 	}
 	Address ra = event.get_replace_address();
@@ -62,8 +160,14 @@ void Garbage_Collector_Greedy::register_event_completion(Event const& event) {
 	if (PRINT_LEVEL > 1) {
 		//printf("Inserting as GC candidate: %ld ", ra.get_linear_address()); ra.print(); printf(" with age_class %d and valid blocks: %d\n", num_live_pages);
 	}
-	gc_candidates[ra.package][ra.die].insert(ra.get_linear_address());
-	if (gc_candidates[ra.package][ra.die].size() == 1) {
+	long block_id = ra.get_block_id();
+	if (bucket_of_block[block_id] != UNDEFINED) {
+		update(ra);
+		return;
+	}
+	int lun = get_lun(ra);
+	insert(block_id, lun, get_block(block_id)->get_pages_valid());
+	if (num_candidates[lun] == 1) {
 		bm->check_if_should_trigger_more_GC(event);
 	}
 }
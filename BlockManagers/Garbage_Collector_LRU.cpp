@@ -8,11 +8,12 @@ Garbage_Collector_LRU::Garbage_Collector_LRU()
 {}
 
 Garbage_Collector_LRU::Garbage_Collector_LRU(Ssd* ssd, Block_manager_parent* bm)
-	:  Garbage_Collector(ssd, bm),
+	:  Garbage_Collector(ssd, bm, "LRU"),
 	   gc_candidates(SSD_SIZE, vector<queue<int> >(PACKAGE_SIZE))
 {}
 
 void Garbage_Collector_LRU::register_event_completion(Event const& event) {
+	count_write(event);
 	if (event.get_event_type() != WRITE) {
 		return;
 	}
@@ -0,0 +1,235 @@
+#include "../ssd.h"
+#include "../block_management.h"
+using namespace ssd;
+
+int Logarithmic_Gecko::ENTRIES_PER_PAGE = 256;
+int Logarithmic_Gecko::SIZE_RATIO = 2;
+
+void logarithmic_gecko_index_entry::print() const {
+	printf("%s", erase_flag ? "erased " : "");
+	for (uint i = 0; i < bitmap.size(); i++) {
+		printf("%d", (int)bitmap[i]);
+	}
+	printf("\n");
+}
+
+Logarithmic_Gecko::Logarithmic_Gecko()
+	:  flash_resident_ftl_garbage_collection(),
+	   scheduler(NULL), buffer(), levels(), pages_of_level(), free_logical_addresses(),
+	   first_logical_address(ceil(NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR)),
+	   next_logical_address(first_logical_address),
+	   looked_up(NUMBER_OF_ADDRESSABLE_BLOCKS(), false),
+	   num_invalidations(0), num_erase_records(0), num_flushes(0), num_merges(0),
+	   num_flash_writes(0), num_merge_reads(0), num_lookups(0), num_lookup_reads(0),
+	   num_pages_found_invalid_in_cache(0)
+{}
+
+Logarithmic_Gecko::Logarithmic_Gecko(Ssd* ssd, Block_manager_parent* bm)
+	:  flash_resident_ftl_garbage_collection(ssd, bm, "logarithmic gecko"),
+	   scheduler(NULL), buffer(), levels(), pages_of_level(), free_logical_addresses(),
+	   first_logical_address(ceil(NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR)),
+	   next_logical_address(first_logical_address),
+	   looked_up(NUMBER_OF_ADDRESSABLE_BLOCKS(), false),
+	   num_invalidations(0), num_erase_records(0), num_flushes(0), num_merges(0),
+	   num_flash_writes(0), num_merge_reads(0), num_lookups(0), num_lookup_reads(0),
+	   num_pages_found_invalid_in_cache(0)
+{}
+
+// The RAM of the index is compared with that of a page-validity bitmap covering all of flash
+Logarithmic_Gecko::~Logarithmic_Gecko() {
+	long num_pages = 0;
+	for (auto& pages : pages_of_level) {
+		num_pages += pages.size();
+	}
+	printf("gecko invalidation records\t%ld\n", num_invalidations);
+	printf("gecko erase records\t%ld\n", num_erase_records);
+	printf("gecko buffer flushes\t%ld\n", num_flushes);
+	printf("gecko merges\t%ld\n", num_merges);
+	printf("gecko levels\t%lu\n", levels.size());
+	printf("gecko flash writes\t%ld\n", num_flash_writes);
+	printf("gecko merge flash reads\t%ld\n", num_merge_reads);
+	printf("gecko lookups\t%ld\n", num_lookups);
+	printf("gecko lookup flash reads\t%ld\n", num_lookup_reads);
+	printf("gecko pages found invalid in mapping cache\t%ld\n", num_pages_found_invalid_in_cache);
+	printf("gecko RAM bytes\t%ld\n", ENTRIES_PER_PAGE * (sizeof(uint) + BLOCK_SIZE / 8 + 1) + num_pages * sizeof(uint));
+	printf("page-validity bitmap RAM bytes\t%u\n", NUMBER_OF_ADDRESSABLE_PAGES() / 8);
+}
+
+void Logarithmic_Gecko::invalid_address_notification(Address const& a, double time) {
+	if (a.valid < PAGE) {
+		return;
+	}
+	buffer[a.get_block_id()].bitmap[a.page] = false;
+	num_invalidations++;
+	if (buffer.size() >= ENTRIES_PER_PAGE) {
+		flush_buffer(time);
+	}
+}
+
+// An erased block gets a record with the erase flag, which hides the older records of the block from lookups and merges
+void Logarithmic_Gecko::register_event_completion(Event const& event) {
+	Garbage_Collector_Greedy::register_event_completion(event);
+	if (event.get_event_type() != ERASE || event.get_noop() || event.get_address().valid < BLOCK) {
+		return;
+	}
+	long block_id = event.get_address().get_block_id();
+	logarithmic_gecko_index_entry erased;
+	erased.erase_flag = true;
+	buffer[block_id] = erased;
+	looked_up[block_id] = false;
+	num_erase_records++;
+	if (buffer.size() >= ENTRIES_PER_PAGE) {
+		flush_buffer(event.get_current_time());
+	}
+}
+
+// The pages of a victim that the index still considers valid are checked against the mapping cache, whose invalidations may not
+// have reached the index yet. The Migrator then migrates exactly the valid pages, which update_bitmap asserts.
+void Logarithmic_Gecko::commit_choice_of_victim(Address const& phys_address, double time) {
+	Garbage_Collector_Greedy::commit_choice_of_victim(phys_address, time);
+	long block_id = phys_address.get_block_id();
+	if (ftl == NULL || looked_up[block_id]) {
+		return;
+	}
+	looked_up[block_id] = true;
+	vector<bool> bitmap = lookup(block_id, time);
+	long num_valid_before = count(bitmap.begin(), bitmap.end(), true);
+	ftl->update_bitmap(bitmap, Address(phys_address.get_linear_address(), BLOCK));
+	num_pages_found_invalid_in_cache += num_valid_before - count(bitmap.begin(), bitmap.end(), true);
+}
+
+// Reads at most one flash page per level, the one whose range of block IDs covers the block, from the newest level to the
+// oldest, and stops at a record with the erase flag
+vector<bool> Logarithmic_Gecko::lookup(long block_id, double time) {
+	num_lookups++;
+	logarithmic_gecko_index_entry result;
+	map<long, logarithmic_gecko_index_entry>::const_iterator buffered = buffer.find(block_id);
+	bool erased = false;
+	if (buffered != buffer.end()) {
+		result = buffered->second;
+		erased = result.erase_flag;
+	}
+	for (uint level = 0; level < levels.size() && !erased; level++) {
+		run const& r = levels[level];
+		if (r.empty() || block_id < r.front().first || block_id > r.back().first) {
+			continue;
+		}
+		run::const_iterator it = lower_bound(r.begin(), r.end(), make_pair(block_id, logarithmic_gecko_index_entry()),
+				[](pair<long, logarithmic_gecko_index_entry> const& a, pair<long, logarithmic_gecko_index_entry> const& b) { return a.first < b.first; });
+		num_lookup_reads += read_page(pages_of_level[level][(it - r.begin()) / ENTRIES_PER_PAGE], time);
+		if (it->first != block_id) {
+			continue;
+		}
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			result.bitmap[i] = result.bitmap[i] && it->second.bitmap[i];
+		}
+		erased = it->second.erase_flag;
+	}
+	return result.bitmap;
+}
+
+// The buffer becomes a run, which is merged down the levels until it fits in one
+void Logarithmic_Gecko::flush_buffer(double time) {
+	run carry(buffer.begin(), buffer.end());
+	buffer.clear();
+	num_flushes++;
+	long capacity = ENTRIES_PER_PAGE;
+	for (uint level = 0; ; level++) {
+		if (level == levels.size()) {
+			levels.push_back(run());
+			pages_of_level.push_back(vector<long>());
+		}
+		capacity *= SIZE_RATIO;
+		if (!levels[level].empty()) {
+			for (auto logical_address : pages_of_level[level]) {
+				num_merge_reads += read_page(logical_address, time);
+			}
+			carry = merge(carry, levels[level], level + 1 == levels.size());
+			free_pages(level);
+			levels[level].clear();
+			num_merges++;
+		}
+		if (carry.size() <= capacity) {
+			levels[level].swap(carry);
+			write_run(level, time);
+			return;
+		}
+	}
+}
+
+// A newer record with the erase flag replaces the older one. Otherwise, a page is valid if both records say so.
+// Nothing is older than the last level, so its records drop the erase flag, and records without invalid pages are dropped.
+Logarithmic_Gecko::run Logarithmic_Gecko::merge(run const& newer, run const& older, bool last_level) const {
+	run merged;
+	merged.reserve(newer.size() + older.size());
+	run::const_iterator n = newer.begin(), o = older.begin();
+	while (n != newer.end() || o != older.end()) {
+		if (o == older.end() || (n != newer.end() && n->first < o->first)) {
+			merged.push_back(*n++);
+		} else if (n == newer.end() || o->first < n->first) {
+			merged.push_back(*o++);
+		} else {
+			merged.push_back(*n);
+			if (!n->second.erase_flag) {
+				logarithmic_gecko_index_entry& entry = merged.back().second;
+				for (int i = 0; i < BLOCK_SIZE; i++) {
+					entry.bitmap[i] = entry.bitmap[i] && o->second.bitmap[i];
+				}
+				entry.erase_flag = o->second.erase_flag;
+			}
+			n++;
+			o++;
+		}
+		if (last_level) {
+			logarithmic_gecko_index_entry& entry = merged.back().second;
+			entry.erase_flag = false;
+			if (find(entry.bitmap.begin(), entry.bitmap.end(), false) == entry.bitmap.end()) {
+				merged.pop_back();
+			}
+		}
+	}
+	return merged;
+}
+
+// Overwriting the logical addresses of runs that were merged away invalidates their flash pages
+void Logarithmic_Gecko::write_run(int level, double time) {
+	for (long i = 0; i < get_num_pages(levels[level]); i++) {
+		long logical_address;
+		if (free_logical_addresses.empty()) {
+			logical_address = next_logical_address++;
+			long num_translation_pages = ceil(NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR / DFTL::ENTRIES_PER_TRANSLATION_PAGE);
+			assert(logical_address < NUMBER_OF_ADDRESSABLE_PAGES() - num_translation_pages);
+		} else {
+			logical_address = free_logical_addresses.front();
+			free_logical_addresses.pop_front();
+		}
+		Event* write = new Event(WRITE, logical_address, 1, time);
+		write->set_mapping_op(true);
+		if (DFTL::SEPERATE_MAPPING_PAGES) {
+			int tag = BLOCK_MANAGER_ID == 5 ? NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR + 1 : 1;
+			write->set_tag(tag);
+		}
+		scheduler->schedule_event(write);
+		pages_of_level[level].push_back(logical_address);
+		num_flash_writes++;
+	}
+}
+
+// Addresses are reused oldest first, so that a page is not overwritten while a merge or lookup is still reading it
+void Logarithmic_Gecko::free_pages(int level) {
+	free_logical_addresses.insert(free_logical_addresses.end(), pages_of_level[level].begin(), pages_of_level[level].end());
+	pages_of_level[level].clear();
+}
+
+// A page whose write has not completed yet is still in the controller's RAM, and is not read
+bool Logarithmic_Gecko::read_page(long logical_address, double time) {
+	Address physical_address = ftl->get_page_mapping()->get_physical_address(logical_address);
+	if (physical_address.valid < PAGE) {
+		return false;
+	}
+	Event* read = new Event(READ, logical_address, 1, time);
+	read->set_mapping_op(true);
+	read->set_address(physical_address);
+	scheduler->schedule_event(read);
+	return true;
+}
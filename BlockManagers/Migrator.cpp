@@ -2,12 +2,28 @@
 using namespace ssd;
 
 Migrator::Migrator() :
-		scheduler(NULL), bm(NULL), gc(NULL), wl(NULL), ftl(NULL), ssd(NULL), page_copy_back_count(),
+		scheduler(NULL), bm(NULL), gc(NULL), wl(NULL), ftl(NULL), ssd(NULL),
+		copy_back_generation(NUMBER_OF_ADDRESSABLE_PAGES(), 0),
 		num_blocks_being_garbaged_collected_per_LUN(SSD_SIZE, vector<uint>(PACKAGE_SIZE, 0)),
 		blocks_being_garbage_collected(),
 		num_erases_scheduled_per_package(SSD_SIZE),
 		dependent_gc(),
-		gc_time_stat()
+		gc_time_stat(),
+		num_foreground_ios(SSD_SIZE * PACKAGE_SIZE, 0),
+		last_foreground_activity(SSD_SIZE * PACKAGE_SIZE, 0),
+		background_gc_check_scheduled(SSD_SIZE * PACKAGE_SIZE, false),
+		background_gc_block(SSD_SIZE * PACKAGE_SIZE, UNDEFINED),
+		num_foreground_ios_at_resume(SSD_SIZE * PACKAGE_SIZE, 0),
+		background_gc_paused(SSD_SIZE * PACKAGE_SIZE, false),
+		num_foreground_gc_ops(0),
+		num_background_gc_ops(0),
+		num_foreground_gc_migrations(0),
+		num_background_gc_migrations(0),
+		num_background_gc_preemptions(0),
+		num_background_gc_promotions(0),
+		num_copy_back_migrations(0),
+		num_copy_backs(0),
+		num_copy_backs_refused_for_ECC(0)
 {
 }
 
@@ -24,6 +40,21 @@ Migrator::~Migrator() {
 		it++;
 	}*/
 	printf("average time for a whole GC operation:\t%f\n", StatisticData::get_average("gc_op_length", 0));
+	if (BACKGROUND_GC_IDLE_WINDOW > 0) {
+		printf("foreground gc operations\t%ld\n", num_foreground_gc_ops);
+		printf("foreground gc migrations\t%ld\n", num_foreground_gc_migrations);
+		printf("background gc operations\t%ld\n", num_background_gc_ops);
+		printf("background gc migrations\t%ld\n", num_background_gc_migrations);
+		printf("background gc preemptions\t%ld\n", num_background_gc_preemptions);
+		printf("background gc promotions\t%ld\n", num_background_gc_promotions);
+	}
+	if (MAX_REPEATED_COPY_BACKS_ALLOWED > 0) {
+		printf("gc copy back migrations\t%ld\n", num_copy_back_migrations);
+		printf("gc copy backs\t%ld\n", num_copy_backs);
+		printf("gc copy backs refused for ECC\t%ld\n", num_copy_backs_refused_for_ECC);
+		printf("channel bytes saved by copy backs\t%ld\n", num_copy_backs * 2 * PAGE_SIZE);
+		printf("channel time saved by copy backs\t%f\n", num_copy_backs * 2 * (BUS_CTRL_DELAY + BUS_DATA_DELAY));
+	}
 	delete gc;
 	delete wl;
 }
@@ -44,7 +75,14 @@ void Migrator::register_event_completion(Event* event) {
 	else if (event->get_event_type() == TRIM || (event->get_event_type() == WRITE && event->get_replace_address().valid != NONE)) {
 		handle_trim_completion(event);
 	}
+	if (event->get_event_type() == WRITE) {
+		copy_back_generation[event->get_address().get_linear_address()] = 0;
+	}
+	else if (event->get_event_type() == COPY_BACK) {
+		handle_copy_back_completion(event);
+	}
 	gc->register_event_completion(*event);
+	wl->register_event_completion(*event);
 }
 
 void Migrator::handle_erase_completion(Event* event) {
@@ -78,6 +116,14 @@ void Migrator::handle_erase_completion(Event* event) {
 	num_blocks_being_garbaged_collected_per_LUN[a.package][a.die]--;
 	blocks_being_garbage_collected.erase(a.get_linear_address());
 
+	int lun = a.package * PACKAGE_SIZE + a.die;
+	if (background_gc_block[lun] == a.get_block_id()) {
+		background_gc_block[lun] = UNDEFINED;
+		if (!background_gc_check_scheduled[lun]) {
+			schedule_background_gc(event->get_current_time(), lun);
+		}
+	}
+
 	if (PRINT_LEVEL > 1) {
 		printf("Finishing GC in %d \n", a.get_linear_address());
 		printf("%lu GC operations taking place now. On:   ", blocks_being_garbage_collected.size());
@@ -88,6 +134,14 @@ void Migrator::handle_erase_completion(Event* event) {
 	}
 }
 
+// The copy keeps the errors its source had, plus any new ones, since it never went through the controller's ECC
+void Migrator::handle_copy_back_completion(Event* event) {
+	uint generation = copy_back_generation[event->get_replace_address().get_linear_address()];
+	copy_back_generation[event->get_address().get_linear_address()] = min(generation + 1, (uint)UCHAR_MAX);
+	num_copy_backs++;
+	handle_trim_completion(event);
+}
+
 void Migrator::handle_trim_completion(Event* event) {
 	Address ra = event->get_replace_address();
 	Block& block = *ssd->get_package(ra.package)->get_die(ra.die)->get_plane(ra.plane)->get_block(ra.block);
@@ -129,6 +183,37 @@ uint Migrator::how_many_gc_operations_are_scheduled() const {
 	return blocks_being_garbage_collected.size();
 }
 
+// How far a LUN is below its garbage-collection watermark of GREED_SCALE free blocks
+int Migrator::get_free_block_deficit(int package, int die) const {
+	return max(0, (int)GREED_SCALE - bm->get_num_free_blocks(package, die));
+}
+
+// A LUN may garbage-collect one block at a time, plus one more for every free block it is missing, up to MAX_GC_OPS_PER_LUN
+int Migrator::get_lun_budget(int package, int die) const {
+	return min(1 + get_free_block_deficit(package, die), MAX_GC_OPS_PER_LUN);
+}
+
+// Half the LUNs of a channel may garbage-collect at once, plus one more operation for every free block its LUNs are missing.
+// MAX_GC_OPS_PER_CHANNEL caps this, and 0 leaves it to the LUN budgets.
+int Migrator::get_channel_budget(int package) const {
+	if (MAX_GC_OPS_PER_CHANNEL <= 0) {
+		return INFINITE;
+	}
+	int deficit = 0;
+	for (uint die = 0; die < PACKAGE_SIZE; die++) {
+		deficit += get_free_block_deficit(package, die);
+	}
+	return min((int)(PACKAGE_SIZE + 1) / 2 + deficit, MAX_GC_OPS_PER_CHANNEL);
+}
+
+int Migrator::get_num_gc_operations_in_channel(int package) const {
+	int sum = 0;
+	for (uint die = 0; die < PACKAGE_SIZE; die++) {
+		sum += num_blocks_being_garbaged_collected_per_LUN[package][die];
+	}
+	return sum;
+}
+
 void Migrator::issue_erase(Address ra, double time) {
 	ra.valid = BLOCK;
 	ra.page = 0;
@@ -164,7 +249,6 @@ void Migrator::issue_erase(Address ra, double time) {
 // schedules a garbage collection operation to occur at a given time, and optionally for a given channel, LUN or age class
 // the block to be reclaimed is chosen when the gc operation is initialised
 void Migrator::schedule_gc(double time, int package, int die, int block, int klass) {
-	Event *gc_event = new Event(GARBAGE_COLLECTION, 0, BLOCK_SIZE, time);
 	Address address;
 	address.package = package;
 	address.die = die;
@@ -183,7 +267,12 @@ void Migrator::schedule_gc(double time, int package, int die, int block, int kla
 	} else {
 		assert(false);
 	}
+	schedule_gc(time, address, klass);
+}
 
+// As above, but the channel, LUN or block is given as an address, so a block on any plane can be targeted
+void Migrator::schedule_gc(double time, Address const& address, int klass) {
+	Event *gc_event = new Event(GARBAGE_COLLECTION, 0, BLOCK_SIZE, time);
 	gc_event->set_noop(true);
 	gc_event->set_address(address);
 	gc_event->set_age_class(klass);
@@ -191,30 +280,103 @@ void Migrator::schedule_gc(double time, int package, int die, int block, int kla
 
 	if (PRINT_LEVEL > 1) {
 		//StateTracer::print();
-		printf("scheduling gc in (%d %d %d %d)  -  ", package, die, block, klass); gc_event->print();
+		printf("scheduling gc in (%d %d %d %d)  -  ", address.valid >= PACKAGE ? (int)address.package : -1, address.valid >= DIE ? (int)address.die : -1, address.valid >= BLOCK ? (int)address.block : -1, klass); gc_event->print();
 	}
 	scheduler->schedule_event(gc_event);
 }
 
-// Returns true if a copy back is allowed on a given logical address
-bool Migrator::copy_back_allowed_on(long logical_address) {
-	if (MAX_REPEATED_COPY_BACKS_ALLOWED <= 0 || MAX_ITEMS_IN_COPY_BACK_MAP <= 0) return false;
-	//map<long, uint>::iterator copy_back_count = page_copy_back_count.find(logical_address);
-	bool address_in_map = page_copy_back_count.count(logical_address) == 1; //(copy_back_count != page_copy_back_count.end());
-	// If address is not in map and map is full, or if page has already been copy backed as many times as allowed, copy back is not allowed
-	if ((!address_in_map && page_copy_back_count.size() >= MAX_ITEMS_IN_COPY_BACK_MAP) ||
-		( address_in_map && page_copy_back_count[logical_address] >= MAX_REPEATED_COPY_BACKS_ALLOWED)) return false;
-	else return true;
+// A wear-leveling operation on a given block, see Wear_Leveling_Strategy::may_wear_level
+void Migrator::schedule_wear_leveling(double time, Address const& block_address) {
+	Event *gc_event = new Event(GARBAGE_COLLECTION, 0, BLOCK_SIZE, time);
+	gc_event->set_noop(true);
+	gc_event->set_address(block_address);
+	gc_event->set_age_class(UNDEFINED);
+	gc_event->set_garbage_collection_op(true);
+	gc_event->set_wear_leveling_op(true);
+	scheduler->schedule_event(gc_event);
 }
 
-// Updates map keeping track of performed copy backs for each logical address
-void Migrator::register_copy_back_operation_on(uint logical_address) {
-	page_copy_back_count[logical_address]++; // Increment copy back counter for target page (if address is not yet in map, it will be inserted and count will become 1)
+// Called by the IOScheduler whenever an IO is issued, after Ssd::issue has advanced the IO's time past its bus transfer
+// and its flash operation. The time recorded is therefore when the IO finishes on its LUN, known as soon as it is issued,
+// so no idle window opens while it is in flight. Application IOs keep their LUN from being idle, and each LUN that
+// receives them gets an idle check BACKGROUND_GC_IDLE_WINDOW after its last one finishes.
+void Migrator::register_die_activity(Event const& event) {
+	if ((BACKGROUND_GC_IDLE_WINDOW <= 0 && WEAR_LEVELING_IDLE_WINDOW <= 0) || event.is_garbage_collection_op() || event.get_address().valid < DIE) {
+		return;
+	}
+	int lun = event.get_address().package * PACKAGE_SIZE + event.get_address().die;
+	num_foreground_ios[lun]++;
+	last_foreground_activity[lun] = max(last_foreground_activity[lun], event.get_current_time());
+	if (BACKGROUND_GC_IDLE_WINDOW > 0 && !background_gc_check_scheduled[lun]) {
+		schedule_background_gc(last_foreground_activity[lun] + BACKGROUND_GC_IDLE_WINDOW, lun);
+	}
 }
 
-// Signals than an ECC check has been performed on a page, meaning that it can be copy backed again in the future
-void Migrator::register_ECC_check_on(uint logical_address) {
-	page_copy_back_count.erase(logical_address);
+void Migrator::schedule_background_gc(double time, int lun) {
+	background_gc_check_scheduled[lun] = true;
+	Event *gc_event = new Event(GARBAGE_COLLECTION, 0, BLOCK_SIZE, time);
+	gc_event->set_noop(true);
+	gc_event->set_address(Address(lun / PACKAGE_SIZE, lun % PACKAGE_SIZE, 0, 0, 0, DIE));
+	gc_event->set_age_class(UNDEFINED);
+	gc_event->set_garbage_collection_op(true);
+	gc_event->set_background_op(true);
+	scheduler->schedule_event(gc_event);
+}
+
+// The idle check of a LUN. If the LUN has been busy since the check was scheduled, the check is pushed back.
+// An idle LUN resumes its paused background operation, or starts a new one if it is short of free blocks.
+bool Migrator::should_garbage_collect_in_background(Address const& lun_address, double time) {
+	int lun = lun_address.package * PACKAGE_SIZE + lun_address.die;
+	background_gc_check_scheduled[lun] = false;
+	if (time < last_foreground_activity[lun] + BACKGROUND_GC_IDLE_WINDOW) {
+		schedule_background_gc(last_foreground_activity[lun] + BACKGROUND_GC_IDLE_WINDOW, lun);
+		return false;
+	}
+	if (background_gc_paused[lun]) {
+		resume_background_gc(lun, time);
+		return false;
+	}
+	return num_blocks_being_garbaged_collected_per_LUN[lun_address.package][lun_address.die] == 0
+			&& bm->get_num_free_blocks(lun_address.package, lun_address.die) < BACKGROUND_GC_FREE_BLOCKS;
+}
+
+void Migrator::resume_background_gc(int lun, double time) {
+	background_gc_paused[lun] = false;
+	num_foreground_ios_at_resume[lun] = num_foreground_ios[lun];
+	long block_id = background_gc_block[lun];
+	for (int i = 0; i < GC_MIGRATION_PIPELINE_DEPTH && dependent_gc.count(block_id) == 1 && dependent_gc.at(block_id).size() > 0; i++) {
+		Event* next = dependent_gc.at(block_id).back().front();
+		if (next->get_current_time() < time) {
+			next->incr_bus_wait_time(time - next->get_current_time());
+		}
+		scheduler->resume_migrations(Address(block_id * BLOCK_SIZE, PAGE), time);
+	}
+}
+
+// Foreground garbage-collection was requested in a LUN that is busy with a background operation, so the background
+// operation runs to completion without pausing again
+void Migrator::promote_background_gc(int lun, double time) {
+	if (background_gc_block[lun] == UNDEFINED) {
+		return;
+	}
+	num_background_gc_promotions++;
+	if (background_gc_paused[lun]) {
+		resume_background_gc(lun, time);
+	}
+	background_gc_block[lun] = UNDEFINED;
+}
+
+// A page may be copied back if its data has been copied back fewer than MAX_REPEATED_COPY_BACKS_ALLOWED times
+// since it last went through the controller, where ECC corrects it
+bool Migrator::copy_back_allowed_on(Address const& page_address) {
+	if (MAX_REPEATED_COPY_BACKS_ALLOWED == 0 || !bm->may_copy_back(page_address)) {
+		return false;
+	}
+	if (copy_back_generation[page_address.get_linear_address()] >= MAX_REPEATED_COPY_BACKS_ALLOWED) {
+		num_copy_backs_refused_for_ECC++;
+		return false;
+	}
+	return true;
 }
 
 void Migrator::update_structures(Address const& a, double time) {
@@ -225,10 +387,32 @@ void Migrator::update_structures(Address const& a, double time) {
 	StatisticsGatherer::get_global_instance()->register_executed_gc(*victim);
 }
 
+// Erases a block whose contents the FTL has discarded, e.g. on a zone reset. Nothing is migrated.
+void Migrator::erase_discarded_block(Address const& a, double time) {
+	Block* block = ssd->get_package(a.package)->get_die(a.die)->get_plane(a.plane)->get_block(a.block);
+	bm->discard_unwritten_pages(BLOCK_SIZE - block->get_pages_valid() - block->get_pages_invalid());
+	gc->commit_choice_of_victim(a, time);
+	blocks_being_garbage_collected[block->get_physical_address()] = 0;
+	num_blocks_being_garbaged_collected_per_LUN[a.package][a.die]++;
+	issue_erase(a, time);
+}
+
 vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 	Address a = gc_event->get_address();
 	vector<deque<Event*> > migrations;
-	if (how_many_gc_operations_are_scheduled() >= MAX_CONCURRENT_GC_OPS) {
+	bool is_background_op = gc_event->is_background_op();
+	if (is_background_op && !should_garbage_collect_in_background(a, gc_event->get_current_time())) {
+		return migrations;
+	}
+	// a wear-leveling operation that is cancelled below is retried, see Wear_Leveling_Strategy::retry_wear_leveling
+	bool is_wear_leveling_op = gc_event->is_wear_leveling_op();
+	bool is_urgent_wear_leveling_op = is_wear_leveling_op && wl->is_urgent();
+	if (MAX_CONCURRENT_GC_OPS > 0 && how_many_gc_operations_are_scheduled() >= MAX_CONCURRENT_GC_OPS && !is_urgent_wear_leveling_op) {
+		if (is_background_op) {
+			schedule_background_gc(gc_event->get_current_time() + BACKGROUND_GC_IDLE_WINDOW, a.package * PACKAGE_SIZE + a.die);
+		} else if (is_wear_leveling_op) {
+			wl->retry_wear_leveling(a, gc_event->get_current_time());
+		}
 		return migrations;
 	}
 	/*bool scheduled_erase_successfully = schedule_queued_erase(a);
@@ -239,8 +423,6 @@ vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 	int die_id = a.valid >= DIE ? a.die : UNDEFINED;
 	int package_id = a.valid >= PACKAGE ? a.package : UNDEFINED;
 
-	bool is_wear_leveling_op = gc_event->is_wear_leveling_op();
-
 	if (gc_event->get_id() == 2332741) {
 		int i = 0;
 		i++;
@@ -252,6 +434,11 @@ vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 	}
 	else {
 		victim = gc->choose_gc_victim(package_id, die_id, gc_event->get_age_class());
+		// a block being garbage-collected becomes a candidate again when one of its pages is invalidated
+		while (victim != NULL && blocks_being_garbage_collected.count(victim->get_physical_address()) == 1) {
+			gc->commit_choice_of_victim(Address(victim->get_physical_address(), BLOCK), gc_event->get_current_time());
+			victim = gc->choose_gc_victim(package_id, die_id, gc_event->get_age_class());
+		}
 	}
 
 	StatisticsGatherer::get_global_instance()->register_scheduled_gc(*gc_event);
@@ -263,13 +450,21 @@ vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 
 	if (bm->get_num_pages_available_for_new_writes() < victim->get_pages_valid()) {
 		StatisticsGatherer::get_global_instance()->num_gc_cancelled_not_enough_free_space++;
+		if (is_wear_leveling_op) wl->retry_wear_leveling(a, gc_event->get_current_time());
 		return migrations;
 	}
 
 	Address addr = Address(victim->get_physical_address(), BLOCK);
 
-	if (num_blocks_being_garbaged_collected_per_LUN[addr.package][addr.die] >= 1) {
+	if (!is_background_op && !is_wear_leveling_op) {
+		promote_background_gc(addr.package * PACKAGE_SIZE + addr.die, gc_event->get_current_time());
+	}
+
+	if (blocks_being_garbage_collected.count(victim->get_physical_address()) == 1
+			|| (!is_urgent_wear_leveling_op && num_blocks_being_garbaged_collected_per_LUN[addr.package][addr.die] >= get_lun_budget(addr.package, addr.die))
+			|| (!is_urgent_wear_leveling_op && get_num_gc_operations_in_channel(addr.package) >= get_channel_budget(addr.package))) {
 		StatisticsGatherer::get_global_instance()->num_gc_cancelled_gc_already_happening++;
+		if (is_wear_leveling_op) wl->retry_wear_leveling(a, gc_event->get_current_time());
 		return migrations;
 	}
 
@@ -286,21 +481,36 @@ vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 		i++;
 	}
 
-	if (victim->get_state() == FREE) {
-		//printf("warning: trying to garbage collect a block that is completely free. This will be ignored.\n");
+	if (victim->get_state() == FREE || victim->get_state() == PARTIALLY_FREE) {
+		//printf("warning: trying to garbage collect a block that is free or partially free. This will be ignored.\n");
+		if (is_wear_leveling_op) wl->retry_wear_leveling(a, gc_event->get_current_time());
 		return migrations;
 	}
 
-	if (victim->get_state() == PARTIALLY_FREE) {
-		//printf("warning: trying to garbage collect a block that is partially free. This will be ignored.\n");
+	if (!bm->may_garbage_collect_this_block(victim, gc_event->get_current_time())) {
+		if (is_wear_leveling_op) wl->retry_wear_leveling(a, gc_event->get_current_time());
 		return migrations;
 	}
 
-	if (!bm->may_garbage_collect_this_block(victim, gc_event->get_current_time())) {
+	// only once nothing above can cancel the operation, which would otherwise be lost after being let through
+	if (is_wear_leveling_op && !wl->may_wear_level(a, gc_event->get_current_time())) {
 		return migrations;
 	}
 
 	update_structures(addr, gc_event->get_current_time());
+	if (is_wear_leveling_op) {
+		wl->schedule_wear_leveling_op(victim, gc_event->get_current_time());
+	}
+	if (is_background_op) {
+		int lun = addr.package * PACKAGE_SIZE + addr.die;
+		background_gc_block[lun] = addr.get_block_id();
+		num_foreground_ios_at_resume[lun] = num_foreground_ios[lun];
+		num_background_gc_ops++;
+		num_background_gc_migrations += victim->get_pages_valid();
+	} else if (!is_wear_leveling_op) {
+		num_foreground_gc_ops++;
+		num_foreground_gc_migrations += victim->get_pages_valid();
+	}
 	//printf("blocks being gced %d\n", blocks_being_garbage_collected.size());
 	bm->subtract_from_available_for_new_writes(victim->get_pages_valid());
 
@@ -343,8 +553,9 @@ vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 			long logical_address = ftl->get_logical_address(addr.get_linear_address());
 			deque<Event*> migration;
 
-			// If a copy back is allowed, and a target page could be reserved, do it. Otherwise, just do a traditional and more expensive READ - WRITE garbage collection
-			if (copy_back_allowed_on(logical_address)) {
+			// A copy back moves the page within its die without using the channel. If the die has no free page when the
+			// copy back is scheduled, it becomes a read transfer and a write, see IOScheduler::transform_copyback.
+			if (copy_back_allowed_on(addr)) {
 
 				Event* read_command = new Event(READ_COMMAND, logical_address, 1, gc_event->get_start_time());
 				read_command->set_address(addr);
@@ -356,10 +567,16 @@ vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 				copy_back->set_garbage_collection_op(true);
 				copy_back->set_copyback(true);
 
+				if (is_wear_leveling_op) {
+					read_command->set_wear_leveling_op(true);
+					copy_back->set_wear_leveling_op(true);
+				}
+				read_command->set_background_op(is_background_op);
+				copy_back->set_background_op(is_background_op);
+
 				migration.push_back(read_command);
 				migration.push_back(copy_back);
-				register_copy_back_operation_on(logical_address);
-				//printf("COPY_BACK MAP (Size: %d):\n", page_copy_back_count.size()); for (map<long, uint>::iterator it = page_copy_back_count.begin(); it != page_copy_back_count.end(); it++) printf(" lba %d\t: %d\n", it->first, it->second);
+				num_copy_back_migrations++;
 			} else {
 				Event* read = new Event(READ, logical_address, 1, gc_event->get_current_time());
 				read->set_address(addr);
@@ -373,16 +590,18 @@ vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 					read->set_wear_leveling_op(true);
 					write->set_wear_leveling_op(true);
 				}
+				read->set_background_op(is_background_op);
+				write->set_background_op(is_background_op);
 
 				migration.push_back(read);
 				migration.push_back(write);
-				//register_ECC_check_on(logical_address); // An ECC check happens in a normal read-write GC operation
 			}
 
+			// the first migrations start right away, and each one that reads its page starts the next
 			long block_id = addr.get_block_id();
-			if (dependent_gc.count(block_id) == 0) {
+			if (dependent_gc.count(block_id) == 0 || migrations.size() < (uint)GC_MIGRATION_PIPELINE_DEPTH) {
 				migrations.push_back(migration);
-				dependent_gc[block_id] = vector<deque<Event* > >();
+				dependent_gc[block_id];
 			}
 			else {
 				dependent_gc.at(block_id).push_back(migration);
@@ -402,10 +621,27 @@ void Migrator::print_pending_migrations() {
 	}
 }
 
+// A background operation pauses here if an application IO has been issued to its LUN since it started or last resumed.
+// It is promoted to a foreground operation instead if the LUN has fallen below its garbage-collection watermark.
 bool Migrator::more_migrations(Event * gc_read) {
 	int block_id = gc_read->get_address().get_block_id();
 	if (dependent_gc.count(block_id) == 1 && dependent_gc.at(block_id).size() > 0) {
-		return true;
+		Address const& a = gc_read->get_address();
+		int lun = a.package * PACKAGE_SIZE + a.die;
+		if (background_gc_block[lun] != block_id || num_foreground_ios[lun] == num_foreground_ios_at_resume[lun]) {
+			return true;
+		}
+		if (background_gc_paused[lun]) {
+			return false;
+		}
+		if (bm->get_num_free_blocks(a.package, a.die) < GREED_SCALE) {
+			background_gc_block[lun] = UNDEFINED;
+			num_background_gc_promotions++;
+			return true;
+		}
+		background_gc_paused[lun] = true;
+		num_background_gc_preemptions++;
+		return false;
 	}
 	else if (dependent_gc.count(block_id) == 1 && dependent_gc.at(block_id).size() == 0) {
 		dependent_gc.erase(block_id);
@@ -76,10 +76,12 @@ void bm_gc_locality::register_write_outcome(Event const& event, enum status stat
 }
 
 Address bm_gc_locality::get_block_for_gc(int package, int die, double current_time) {
-	vector<int> packages = Random_Order_Iterator::get_iterator(SSD_SIZE);
-	for (auto p : packages) {
-		vector<int> dies = Random_Order_Iterator::get_iterator(PACKAGE_SIZE);
-		for (auto d : dies) {
+	Random_Permutation packages(SSD_SIZE);
+	while (packages.has_next()) {
+		int p = packages.next();
+		Random_Permutation dies(PACKAGE_SIZE);
+		while (dies.has_next()) {
+			int d = dies.next();
 			if (package == p && die == d) {
 				continue;
 			}
@@ -119,6 +121,7 @@ void bm_gc_locality::register_erase_outcome(Event& event, enum status status) {
 	Address partially_free_block = pointers_for_ongoing_gc_operations.at(block);
 	if (has_free_pages(partially_free_block) && !has_free_pages(free_block_pointers[partially_free_block.package][partially_free_block.die])) {
 		free_block_pointers[partially_free_block.package][partially_free_block.die] = partially_free_block;
+		mark_lun_for_update(partially_free_block.package, partially_free_block.die);
 	}
 	else if (has_free_pages(partially_free_block)) {
 		partially_used_blocks[partially_free_block.package][partially_free_block.die].push(partially_free_block);
@@ -133,6 +136,7 @@ void bm_gc_locality::register_erase_outcome(Event& event, enum status status) {
 		if (has_free_pages(free_block_pointers[a.package][a.die])) {
 			Free_Space_Per_LUN_Meter::mark_new_space(a, event.get_current_time());
 		}
+		update_gc_watermark(a.package, a.die);
 	}
 }
 
@@ -145,6 +149,7 @@ void bm_gc_locality::check_if_should_trigger_more_GC(Event const& event) {
 				Address pointer = partially_used_blocks[i][j].front();
 				partially_used_blocks[i][j].pop();
 				free_block_pointers[i][j] = pointer;
+				mark_lun_for_update(i, j);
 				printf("made swap!\n");
 			}
 			/*else if (!has_free_pages(free_block_pointers[i][j]) ) {
@@ -5,19 +5,27 @@ using namespace ssd;
 
 Shortest_Queue_Hot_Cold_BM::Shortest_Queue_Hot_Cold_BM()
 	: Block_manager_parent(1),
-	  page_hotness_measurer(),
-	  cold_pointer(find_free_unused_block(0))
+	  page_hotness_measurer(Page_Hotness_Measurer::get_new_instance()),
+	  cold_pointer()
 {}
 
-Shortest_Queue_Hot_Cold_BM::~Shortest_Queue_Hot_Cold_BM() {}
+// The cold pointer can only be picked once the parent has filled the free block pools and knows the migrator
+void Shortest_Queue_Hot_Cold_BM::init(Ssd* ssd, FtlParent* ftl, IOScheduler* sched, Garbage_Collector* gc, Wear_Leveling_Strategy* wl, Migrator* migrator) {
+	Block_manager_parent::init(ssd, ftl, sched, gc, wl, migrator);
+	cold_pointer = find_free_unused_block(0);
+}
+
+Shortest_Queue_Hot_Cold_BM::~Shortest_Queue_Hot_Cold_BM() {
+	delete page_hotness_measurer;
+}
 
 void Shortest_Queue_Hot_Cold_BM::register_write_outcome(Event const& event, enum status status) {
 	Block_manager_parent::register_write_outcome(event, status);
-	page_hotness_measurer.register_event(event);
+	page_hotness_measurer->register_event(event);
 
 	if (event.get_address().compare(cold_pointer) >= BLOCK) {
 		cold_pointer.page = cold_pointer.page + 1;
-		printf("cold write:   "); event.print();
+		if (PRINT_LEVEL >= 1) { printf("cold write:   "); event.print(); }
 		if (!has_free_pages(cold_pointer)) {
 			handle_cold_pointer_out_of_space(event.get_current_time());
 		}
@@ -41,6 +49,7 @@ void Shortest_Queue_Hot_Cold_BM::register_erase_outcome(Event& event, enum statu
 	// when we trigger GC for a cold pointer, remember which block was chosen.
 	if (!has_free_pages(free_block_pointers[addr.package][addr.die])) {
 		free_block_pointers[addr.package][addr.die] = find_free_unused_block(addr.package, addr.die, YOUNG, event.get_current_time());
+		update_gc_watermark(addr.package, addr.die);
 	}
 	else if (!has_free_pages(cold_pointer)) {
 		cold_pointer = find_free_unused_block(OLD, event.get_current_time());
@@ -51,7 +60,7 @@ void Shortest_Queue_Hot_Cold_BM::register_erase_outcome(Event& event, enum statu
 
 
 Address Shortest_Queue_Hot_Cold_BM::choose_best_address(Event& write) {
-	enum write_hotness w_hotness = page_hotness_measurer.get_write_hotness(write.get_logical_address());
+	enum write_hotness w_hotness = page_hotness_measurer->get_write_hotness(write.get_logical_address());
 	//w_hotness = WRITE_HOT;
 	return w_hotness == WRITE_HOT ? get_free_block_pointer_with_shortest_IO_queue() : cold_pointer;
 }
@@ -63,7 +72,7 @@ Address Shortest_Queue_Hot_Cold_BM::choose_any_address(Event const& write) {
 
 void Shortest_Queue_Hot_Cold_BM::register_read_command_outcome(Event const& event, enum status status){
 	if (status == SUCCESS && !event.is_garbage_collection_op()) {
-		page_hotness_measurer.register_event(event);
+		page_hotness_measurer->register_event(event);
 	}
 }
 
@@ -15,6 +15,7 @@
 using namespace ssd;
 
 int Block_Manager_Groups::detector_type = 0;
+double Block_Manager_Groups::op_reallocation_period = 100000;
 int Block_Manager_Groups::reclamation_threshold = 0;
 bool Block_Manager_Groups::prioritize_groups_that_need_blocks = 0;
 int Block_Manager_Groups::garbage_collection_policy_within_groups = 0;
@@ -24,8 +25,13 @@ int bloom_detector::max_num_groups = 20;
 int bloom_detector::min_num_groups = 5;
 double bloom_detector::bloom_false_positive_probability = 0.1;
 
+int sketch_detector::num_groups = 2;
+int sketch_detector::sketch_width = 1 << 14;
+double sketch_detector::band_ratio = 4;
+double sketch_detector::aging_interval = 4;
+
 Block_Manager_Groups::Block_Manager_Groups()
-: Block_manager_parent(), stats(), groups(), detector(NULL)
+: Block_manager_parent(), stats(), groups(), next_op_reallocation(op_reallocation_period), writes_at_last_reallocation(), num_op_reallocations(0), detector(NULL)
 {
 	GREED_SCALE = 0;
 }
@@ -33,6 +39,16 @@ Block_Manager_Groups::Block_Manager_Groups()
 Block_Manager_Groups::~Block_Manager_Groups() {
 	printf("final printing:\n");
 	print();
+	if (detector_type == 4) {
+		printf("over-provisioning reallocations\t%d\n", num_op_reallocations);
+		for (uint i = 0; i < groups.size(); i++) {
+			group::group_stats const& s = groups[i].stats;
+			printf("group %d pages\t%d\n", i, groups[i].num_pages);
+			printf("group %d OP\t%d\n", i, (int)groups[i].OP);
+			printf("group %d write amp\t%f\n", i, s.num_writes_to_group == 0 ? 0 : (s.num_writes_to_group + s.num_gc_writes_to_group) / (double)s.num_writes_to_group);
+		}
+	}
+	delete detector;
 }
 
 void Block_Manager_Groups::init_detector() {
@@ -48,6 +64,9 @@ void Block_Manager_Groups::init_detector() {
 	else if (detector_type == 2) {
 		detector = new non_adaptive_bloom_detector(groups, this);
 	}
+	else if (detector_type == 4) {
+		detector = new sketch_detector(groups, this);
+	}
 	else {
 		detector = new tag_based_with_prob_recomp(groups, this);
 	}
@@ -58,15 +77,18 @@ void Block_Manager_Groups::init(Ssd* ssd, FtlParent* ftl, IOScheduler* sched, Ga
 	for (int i = 0; i < SSD_SIZE; i++) {
 		for (int j = 0; j < PACKAGE_SIZE; j++) {
 			Address a = free_block_pointers[i][j];
-			free_blocks[i][j][0].push_back(a);
+			add_free_block(a, 0);
 			free_block_pointers[i][j] = Address();
 		}
 	}
 	assert(get_num_free_blocks() == SSD_SIZE * PACKAGE_SIZE * PLANE_SIZE);
 	//group::mapping_pages_to_groups =  vector<int>(NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR + 1, UNDEFINED);
 	//group::mapping_pages_to_tags =  vector<int>(NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR + 1, UNDEFINED);
-	group::mapping_pages_to_groups =  vector<int>(NUMBER_OF_ADDRESSABLE_PAGES() + 1, UNDEFINED);
-	group::mapping_pages_to_tags =  vector<int>(NUMBER_OF_ADDRESSABLE_PAGES() + 1, UNDEFINED);
+	// The sketch detector keeps nothing per logical address. The maps stay empty, and the group a page was in is that of its block.
+	if (detector_type != 4) {
+		group::mapping_pages_to_groups =  vector<int>(NUMBER_OF_ADDRESSABLE_PAGES() + 1, UNDEFINED);
+		group::mapping_pages_to_tags =  vector<int>(NUMBER_OF_ADDRESSABLE_PAGES() + 1, UNDEFINED);
+	}
 	if (groups.size() == 0) {
 		groups.push_back(group(1, NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR, this, ssd, 0));
 	}
@@ -138,6 +160,7 @@ void Block_Manager_Groups::receive_message(Event const& message) {
 }
 
 void Block_Manager_Groups::register_write_arrival(Event const& e) {
+	detector->register_write_arrival(e);
 	/*printf("groups.size(): %d\n", groups.size());
 	if (e.get_tag() == groups.size()) {
 		group g(0, 1, this, ssd, groups.size());
@@ -174,7 +197,8 @@ void Block_Manager_Groups::register_write_outcome(Event const& event, enum statu
 	Block_manager_parent::register_write_outcome(event, status);
 
 	int la = event.get_logical_address();
-	int prior_group_id = group::mapping_pages_to_groups.at(la);
+	bool streaming = group::mapping_pages_to_groups.empty();
+	int prior_group_id = streaming ? get_group_of_block(event.get_replace_address()) : group::mapping_pages_to_groups.at(la);
 	int ideal_group_id = detector->which_group_should_this_page_belong_to(event);
 	if (ideal_group_id == 1) {
 		int i = 0;
@@ -201,9 +225,15 @@ void Block_Manager_Groups::register_write_outcome(Event const& event, enum statu
 			actual_new_group = i;
 		}
 	}
+	// Without a map of logical addresses, a page is counted in the group that holds its block
+	if (streaming && actual_new_group != UNDEFINED) {
+		ideal_group_id = actual_new_group;
+	}
 
 	if (prior_group_id == UNDEFINED) {
-		group::mapping_pages_to_groups[la] = ideal_group_id;
+		if (!streaming) {
+			group::mapping_pages_to_groups[la] = ideal_group_id;
+		}
 		groups[ideal_group_id].num_pages++;
 	}
 	else if (prior_group_id != ideal_group_id) {
@@ -211,7 +241,9 @@ void Block_Manager_Groups::register_write_outcome(Event const& event, enum statu
 		groups[ideal_group_id].num_pages++;
 		groups[ideal_group_id].stats.migrated_in++;
 		groups[prior_group_id].stats.migrated_out++;
-		group::mapping_pages_to_groups[la] = ideal_group_id;
+		if (!streaming) {
+			group::mapping_pages_to_groups[la] = ideal_group_id;
+		}
 	}
 
 	groups[ideal_group_id].num_pages_per_die[event.get_address().package][event.get_address().die]++;
@@ -235,6 +267,13 @@ void Block_Manager_Groups::register_write_outcome(Event const& event, enum statu
 
 	detector->register_write_completed(event, prior_group_id, ideal_group_id);
 
+	if (streaming) {
+		if (event.get_current_time() >= next_op_reallocation) {
+			reallocate_op(event.get_current_time());
+		}
+		return;
+	}
+
 	if (groups[ideal_group_id].num_pages > groups[ideal_group_id].size * 1.05 || groups[ideal_group_id].actual_prob > groups[ideal_group_id].prob * 1.05) {
 		//printf("regrouping due to change!!!\n");
 		for (int i = 0; i < groups.size(); i++) {
@@ -694,6 +733,9 @@ void Block_Manager_Groups::try_to_allocate_block_to_group(int group_id, int pack
 		stats.num_normal_gc_operations_requested++;
 		request_gc(group_id, package, die, time);
 	}*/
+	// With the sketch detector, pages move between groups as they heat up and cool down, so a group can be left with far
+	// more blocks than it needs. A group short of blocks takes them from such a group rather than garbage-collecting itself.
+	else if (detector_type == 4 && (!has_free_block || !has_reserve_block) && needs_more_blocks && trigger_gc_in_same_lun_but_different_group(package, die, group_id, time)) {}
 	else if ((!has_free_block || !has_reserve_block) && (needs_more_blocks || groups[group_id].in_equilbirium())) {
 		stats.num_normal_gc_operations_requested++;
 		request_gc(group_id, package, die, time);
@@ -849,6 +891,11 @@ void Block_Manager_Groups::request_gc(int group_id, int package, int die, double
 	else {
 		b = groups[group_id].get_gc_victim_window_greedy(package, die);
 	}
+	// Garbage-collecting a block with no invalid pages frees nothing. Once the writes stop, a group short of blocks would
+	// otherwise keep migrating its full blocks, each erase triggering the next, so the least valid block is taken instead.
+	if (b != NULL && b->get_pages_valid() == BLOCK_SIZE) {
+		b = groups[group_id].get_gc_victim_greedy(package, die);
+	}
 	if (b != NULL) {
 		Address block_addr = Address(b->get_physical_address() , BLOCK);
 		migrator->schedule_gc(time, package, die, block_addr.block, UNDEFINED);
@@ -861,7 +908,7 @@ Address Block_Manager_Groups::choose_best_address(Event& write) {
 		int i = 0;
 		i++;
 	}
-	if (write.is_garbage_collection_op() && write.get_tag() == UNDEFINED) {
+	if (write.is_garbage_collection_op() && write.get_tag() == UNDEFINED && !group::mapping_pages_to_tags.empty()) {
 		int tag = group::mapping_pages_to_tags.at(write.get_logical_address());
 		write.set_tag(tag);
 	}
@@ -896,6 +943,64 @@ Address Block_Manager_Groups::choose_any_address(Event const& write) {
 	return Address();
 }
 
+// The group whose blocks include the block of a page, or UNDEFINED if the address is not of a page
+int Block_Manager_Groups::get_group_of_block(Address const& address) const {
+	if (address.valid != PAGE) {
+		return UNDEFINED;
+	}
+	Block* block = ssd->get_package(address.package)->get_die(address.die)->get_plane(address.plane)->get_block(address.block);
+	for (uint i = 0; i < groups.size(); i++) {
+		if (groups[i].block_ids.count(block) == 1) {
+			return i;
+		}
+	}
+	return UNDEFINED;
+}
+
+// With the sketch detector, over-provisioning is reallocated every op_reallocation_period of simulated time rather than when
+// the groups drift. The update probability of a group is a moving average of its share of the application writes since the
+// last reallocation. Each group's OP moves towards the closed-form target by at most a block per LUN, which avoids bursts of
+// garbage-collection when the workload shifts. Nothing is reallocated before half of the logical space has been written,
+// since the group sizes and shares say little until then, and the first reallocation sets the targets outright.
+void Block_Manager_Groups::reallocate_op(double current_time) {
+	next_op_reallocation = current_time + op_reallocation_period;
+	writes_at_last_reallocation.resize(groups.size(), 0);
+	long num_writes = 0;
+	for (uint i = 0; i < groups.size(); i++) {
+		num_writes += groups[i].stats.num_writes_to_group - writes_at_last_reallocation[i];
+	}
+	double PBA = NUMBER_OF_ADDRESSABLE_PAGES(), LBA = 0;
+	for (auto const& g : groups) {
+		LBA += g.num_pages;
+	}
+	if (num_writes == 0 || LBA < NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR / 2) {
+		for (uint i = 0; i < groups.size(); i++) {
+			writes_at_last_reallocation[i] = groups[i].stats.num_writes_to_group;
+		}
+		return;
+	}
+	bool first = num_op_reallocations == 0;
+	double max_step = SSD_SIZE * PACKAGE_SIZE * BLOCK_SIZE;
+	double total_OP = 0;
+	for (uint i = 0; i < groups.size(); i++) {
+		double share = (groups[i].stats.num_writes_to_group - writes_at_last_reallocation[i]) / (double)num_writes;
+		writes_at_last_reallocation[i] = groups[i].stats.num_writes_to_group;
+		groups[i].prob = groups[i].actual_prob = first ? share : groups[i].actual_prob * 0.5 + share * 0.5;
+		groups[i].size = groups[i].num_pages;
+		double OP = groups[i].OP;
+		double target = groups[i].get_average_op(PBA, LBA);
+		groups[i].OP = first ? target : OP + max(-max_step, min(target - OP, max_step));
+		total_OP += groups[i].OP;
+	}
+	// the steps towards the targets must not hand out more OP than there is
+	if (total_OP > PBA - LBA) {
+		for (auto& g : groups) {
+			g.OP *= (PBA - LBA) / total_OP;
+		}
+	}
+	num_op_reallocations++;
+}
+
 void Block_Manager_Groups::add_group(double starting_prob_val) {
 	group new_group = group(starting_prob_val, BLOCK_SIZE, this, ssd, groups.size());
 	groups.push_back(new_group);
@@ -1173,7 +1278,7 @@ void bloom_detector::group_interval_finished(int group_id) {
 	params.false_positive_probability = bloom_false_positive_probability;
 	params.projected_element_count = groups[group_id].num_pages;
 	params.compute_optimal_parameters();
-	data[group_id]->filters[0] = new bloom_filter(params);
+	data[group_id]->filters[0] = new blocked_bloom_filter(params);
 	data[group_id]->age_in_group_periods++;
 	//printf("group %d interval finished. num intervals %d\n", group_id, data[group_id]->age_in_group_periods);
 
@@ -1255,7 +1360,7 @@ bloom_detector::group_data::group_data(group const& group_ref, vector<group>& gr
 	params.false_positive_probability = bloom_false_positive_probability;
 	params.projected_element_count = group_ref.size;
 	params.compute_optimal_parameters();
-	filters[0] = new bloom_filter(params);
+	filters[0] = new blocked_bloom_filter(params);
 }
 
 bloom_detector::group_data::group_data() :
@@ -1442,3 +1547,42 @@ int tag_based_with_prob_recomp::which_group_should_this_page_belong_to(Event con
 	return event.get_tag();
 }
 
+sketch_detector::sketch_detector(vector<group>& groups, Block_Manager_Groups* bm) :
+	temperature_detector(groups), sketch(sketch_width), writes_until_aging(0), num_agings(0)
+{
+	for (int i = groups.size(); i < num_groups; i++) {
+		bm->add_group(0);
+	}
+	writes_until_aging = NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR * aging_interval;
+}
+
+sketch_detector::~sketch_detector() {
+	printf("sketch agings\t%ld\n", num_agings);
+	printf("sketch bytes\t%lu\n", sketch.get_size_in_bytes());
+	printf("per-page group and tag map bytes\t%lu\n", 2 * sizeof(int) * (NUMBER_OF_ADDRESSABLE_PAGES() + 1));
+}
+
+// Like a page written for the first time with the bloom detectors, a page with no recent write but the one being placed goes
+// to the coldest group
+int sketch_detector::which_group_should_this_page_belong_to(Event const& event) {
+	double mean = sketch.get_total() / (NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR);
+	uint count = sketch.estimate(event.get_logical_address());
+	if (count <= 1) {
+		return 0;
+	}
+	int band = floor(log(count / mean) / log(band_ratio) + groups.size() / 2.0);
+	return max(0, min(band, (int)groups.size() - 1));
+}
+
+// Counted at arrival, so the write being placed is included in its own estimate
+void sketch_detector::register_write_arrival(Event const& event) {
+	if (!event.is_original_application_io()) {
+		return;
+	}
+	sketch.add(event.get_logical_address());
+	if (--writes_until_aging <= 0) {
+		sketch.halve();
+		num_agings++;
+		writes_until_aging = NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR * aging_interval;
+	}
+}
@@ -7,6 +7,7 @@ using namespace std;
 Sequential_Locality_BM::Sequential_Locality_BM()
 	: Block_manager_parallel(),
 	  seq_write_key_to_pointers_mapping(),
+	  pointer_owners(),
 	  detector(new Sequential_Pattern_Detector(SEQUENTIAL_LOCALITY_THRESHOLD)),
 	  strat(SHOREST_QUEUE),
 	  random_number_generator(1111),
@@ -105,7 +106,7 @@ Address Sequential_Locality_BM::choose_any_address(Event const& write) {
 	if (can_schedule_write_immediately(a, write.get_current_time())) {
 		return a;
 	}
-	map<long, sequential_writes_pointers >::iterator iter = seq_write_key_to_pointers_mapping.begin();
+	unordered_map<long, sequential_writes_pointers >::iterator iter = seq_write_key_to_pointers_mapping.begin();
 	for (; iter != seq_write_key_to_pointers_mapping.end(); iter++) {
 		vector<vector<Address> >& pointers = (*iter).second.pointers;
 		for (uint i = 0; i < pointers.size(); i++) {
@@ -171,7 +172,7 @@ void Sequential_Locality_BM::set_pointers_for_sequential_write(long key, double
 		seq_write_key_to_pointers_mapping[key].pointers = vector<vector<Address> >(1, vector<Address>(1));
 		Address free_block = find_free_unused_block(time);
 		if (free_block.valid != NONE) {
-			seq_write_key_to_pointers_mapping[key].pointers[0][0] = free_block;
+			set_pointer(key, 0, 0, free_block);
 			seq_write_key_to_pointers_mapping[key].num_pointers++;
 		}
 	} else if (parallel_degree == CHANNEL) {
@@ -179,7 +180,7 @@ void Sequential_Locality_BM::set_pointers_for_sequential_write(long key, double
 		for (uint i = 0; i < SSD_SIZE; i++) {
 			Address free_block = find_free_unused_block(i, time);
 			if (free_block.valid != NONE) {
-				seq_write_key_to_pointers_mapping[key].pointers[i][0] = free_block;
+				set_pointer(key, i, 0, free_block);
 				seq_write_key_to_pointers_mapping[key].num_pointers++;
 			}
 		}
@@ -189,7 +190,7 @@ void Sequential_Locality_BM::set_pointers_for_sequential_write(long key, double
 			for (uint j = 0; j < PACKAGE_SIZE; j++) {
 				Address free_block = find_free_unused_block(i, j, time);
 				if (free_block.valid != NONE) {
-					seq_write_key_to_pointers_mapping[key].pointers[i][j] = free_block;
+					set_pointer(key, i, j, free_block);
 					seq_write_key_to_pointers_mapping[key].num_pointers++;
 				}
 			}
@@ -204,7 +205,7 @@ void Sequential_Locality_BM::set_pointers_for_tagged_sequential_write(int tag, d
 	int key = tag_map[tag].key;
 	assert(key >= 0);
 	seq_write_key_to_pointers_mapping[key].tag = tag;
-	vector<vector<Address> >& pointers = seq_write_key_to_pointers_mapping[key].pointers = vector<vector<Address> >(SSD_SIZE, vector<Address>(PACKAGE_SIZE));
+	seq_write_key_to_pointers_mapping[key].pointers = vector<vector<Address> >(SSD_SIZE, vector<Address>(PACKAGE_SIZE));
 	int random_offset = random_number_generator();
 	//num_blocks_to_allocate_now = 1;
 	for (int i = 0 ; i < num_blocks_to_allocate_now; i++) {
@@ -217,7 +218,7 @@ void Sequential_Locality_BM::set_pointers_for_tagged_sequential_write(int tag, d
 			seq_write_key_to_pointers_mapping[key].num_pointers++;
 			assert(package == free_block.package);
 			assert(die == free_block.die);
-			pointers[package][die] = free_block;
+			set_pointer(key, package, die, free_block);
 		}
 	}
 }
@@ -268,7 +269,7 @@ void Sequential_Locality_BM::process_write_completion(Event const& event, long k
 			}
 		}
 		if (has_free_pages(free_block)) {
-			swp.pointers[index.first][index.second] = free_block;
+			set_pointer(key, index.first, index.second, free_block);
 		} else {
 			swp.num_pointers--;
 		}
@@ -299,21 +300,17 @@ void Sequential_Locality_BM::register_write_outcome(Event const& event, enum sta
 		tag_map[tag].num_written++;
 	}
 
-	map<long, sequential_writes_pointers >::iterator iter = seq_write_key_to_pointers_mapping.begin();
 	bool found = false;
-	for (; iter != seq_write_key_to_pointers_mapping.end(); iter++) {
-		vector<vector<Address> >& pointers = (*iter).second.pointers;
-		for (uint i = 0; i < pointers.size(); i++) {
-			for (uint j = 0; j < pointers[i].size(); j++) {
-				if (has_free_pages(pointers[i][j]) && event.get_address().compare(pointers[i][j]) >= BLOCK) {
-					long key = (*iter).first;
-					pair<long, long> index(i, j);
-					process_write_completion(event, key, index);
-					found = true;
-				}
-			}
+	unordered_map<long, pointer_owner>::iterator owner = pointer_owners.find(event.get_address().get_block_id());
+	if (owner != pointer_owners.end()) {
+		pointer_owner o = (*owner).second;
+		Address const& pointer = seq_write_key_to_pointers_mapping[o.key].pointers[o.package][o.die];
+		if (has_free_pages(pointer) && event.get_address().compare(pointer) >= BLOCK) {
+			process_write_completion(event, o.key, pair<long, long>(o.package, o.die));
+			found = true;
 		}
 	}
+	arrived_writes_to_sequential_key_mapping.erase(event.get_id());
 
 	if (tag != UNDEFINED && tag_map[tag].is_finished()) {
 		sequential_event_metadata_removed(tag_map[tag].key, event.get_current_time());
@@ -334,7 +331,8 @@ void Sequential_Locality_BM::sequential_event_metadata_removed(long key, double
 	//printf("Returning key %d: \n", key );
 	for (uint i = 0; i < a.pointers.size(); i++) {
 		for (uint j = 0; j < a.pointers[i].size(); j++) {
-			Address& pointer = a.pointers[i][j];
+			Address pointer = a.pointers[i][j];
+			set_pointer(key, i, j, Address());
 			Block_manager_parent::return_unfilled_block(pointer, current_time, true);
 		}
 	}
@@ -354,7 +352,7 @@ void Sequential_Locality_BM::register_erase_outcome(Event& event, enum status st
 		j = event.get_address().die;
 	}
 
-	map<long, sequential_writes_pointers >::iterator iter = seq_write_key_to_pointers_mapping.begin();
+	unordered_map<long, sequential_writes_pointers >::iterator iter = seq_write_key_to_pointers_mapping.begin();
 	for (; iter != seq_write_key_to_pointers_mapping.end(); iter++) {
 		sequential_writes_pointers& swt = (*iter).second;
 		long key = (*iter).first;
@@ -375,12 +373,27 @@ void Sequential_Locality_BM::register_erase_outcome(Event& event, enum status st
 			}
 			if (has_free_pages(new_block)) {
 				swt.num_pointers++;
-				swt.pointers[i][j] = new_block;
+				set_pointer(key, i, j, new_block);
 			}
 		}
 	}
 }
 
+// Sets one of the pointers of a sequential write, and keeps the index from block IDs to pointers up to date
+void Sequential_Locality_BM::set_pointer(long key, int package, int die, Address const& block) {
+	Address& pointer = seq_write_key_to_pointers_mapping[key].pointers[package][die];
+	if (pointer.valid != NONE) {
+		unordered_map<long, pointer_owner>::iterator owner = pointer_owners.find(pointer.get_block_id());
+		if (owner != pointer_owners.end() && (*owner).second.key == key && (*owner).second.package == package && (*owner).second.die == die) {
+			pointer_owners.erase(owner);
+		}
+	}
+	pointer = block;
+	if (block.valid != NONE) {
+		pointer_owners[block.get_block_id()] = pointer_owner(key, package, die);
+	}
+}
+
 Sequential_Locality_BM::sequential_writes_pointers::sequential_writes_pointers()
 	: num_pointers(0),
 	  pointers(),
@@ -16,26 +16,42 @@ using namespace ssd;
 using namespace std;
 
 double Block_manager_parent::soonest_write_time = 0;
+MTRand_int32 Block_manager_parent::random_number_generator = MTRand_int32(873462456);
 
 Block_manager_parent::Block_manager_parent(int num_age_classes)
  : ssd(NULL),
    ftl(NULL),
    free_block_pointers(SSD_SIZE, vector<Address>(PACKAGE_SIZE)),
-   free_blocks(SSD_SIZE, vector<vector<deque<Address> > >(PACKAGE_SIZE, vector<deque<Address> >(num_age_classes, deque<Address>(0)) )),
+   free_blocks(SSD_SIZE * PACKAGE_SIZE * num_age_classes),
    all_blocks(0),
    num_age_classes(num_age_classes),
    num_free_pages(SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE * BLOCK_SIZE),
    num_available_pages_for_new_writes(SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE * BLOCK_SIZE),
-   IO_has_completed_since_last_shortest_queue_search(true),
+   non_empty_age_classes(SSD_SIZE * PACKAGE_SIZE, 0),
+   num_free_blocks_per_lun(SSD_SIZE * PACKAGE_SIZE, 0),
+   luns_below_gc_watermark(),
+   die_availability(SSD_SIZE, Tournament_Tree(PACKAGE_SIZE)),
+   package_availability(SSD_SIZE),
+   idle_register_dies(SSD_SIZE, Tournament_Tree(PACKAGE_SIZE)),
+   busy_register_dies(SSD_SIZE, Tournament_Tree(PACKAGE_SIZE)),
+   soonest_write_per_package(SSD_SIZE),
+   num_write_scheduling_queries(0),
+   lun_needs_update(SSD_SIZE, vector<bool>(PACKAGE_SIZE, false)),
+   luns_to_update(),
    erase_queue(SSD_SIZE, queue< Event*>()),
    num_erases_scheduled_per_package(SSD_SIZE, 0),
    scheduler(NULL),
    wl(NULL),
    gc(NULL),
    migrator(NULL)
-{}
+{
+	assert(num_age_classes <= 64);
+}
 
 Block_manager_parent::~Block_manager_parent() {
+	if (PRINT_LEVEL >= 1) {
+		printf("write scheduling queries\t%ld\n", num_write_scheduling_queries);
+	}
 }
 
 void Block_manager_parent::init(Ssd* new_ssd, FtlParent* new_ftl, IOScheduler* new_sched, Garbage_Collector* new_gc, Wear_Leveling_Strategy* new_wl, Migrator* new_migrator) {
@@ -51,14 +67,20 @@ void Block_manager_parent::init(Ssd* new_ssd, FtlParent* new_ftl, IOScheduler* n
 				Plane* plane = die->get_plane(t);
 				for (uint b = 0; b < PLANE_SIZE; b++) {
 					Block* block = plane->get_block(b);
-					free_blocks[i][j][0].push_back(Address(block->get_physical_address(), PAGE));
+					add_free_block(Address(block->get_physical_address(), PAGE), 0);
 					all_blocks.push_back(block);
 				}
 			}
-			Address pointer = free_blocks[i][j][0].back();
+			vector<Address>& pool = free_blocks[get_pool_id(i, j, 0)];
+			Address pointer = pool.back();
+			pool.pop_back();
+			num_free_blocks_per_lun[i * PACKAGE_SIZE + j]--;
+			if (pool.empty()) {
+				non_empty_age_classes[i * PACKAGE_SIZE + j] = 0;
+			}
 			free_block_pointers[i][j] = pointer;
 			Free_Space_Per_LUN_Meter::mark_new_space(pointer, 0);
-			free_blocks[i][j][0].pop_back();
+			mark_lun_for_update(i, j);
 		}
 	}
 	wl = new_wl;
@@ -72,6 +94,7 @@ Address Block_manager_parent::choose_copbyback_address(Event const& write) {
 		Address new_block = find_free_unused_block(ra.package, ra.die, write.get_current_time());
 		if (has_free_pages(new_block)) {
 			free_block_pointers[ra.package][ra.die] = new_block;
+			mark_lun_for_update(ra.package, ra.die);
 			Free_Space_Per_LUN_Meter::mark_new_space(new_block, write.get_current_time());
 		}
 	}
@@ -106,6 +129,7 @@ Address Block_manager_parent::choose_write_address(Event& write) {
 	}
 
 	if (GREED_SCALE > 0 && !write.is_garbage_collection_op() && migrator->how_many_gc_operations_are_scheduled() == 0) {
+		StatisticsGatherer::get_global_instance()->num_gc_triggered_write_blocked++;
 		migrator->schedule_gc(write.get_current_time(), -1, -1, -1 ,-1);
 	}
 	if (write.is_garbage_collection_op() || migrator->how_many_gc_operations_are_scheduled() == 0) {
@@ -118,8 +142,6 @@ Address Block_manager_parent::choose_write_address(Event& write) {
 }
 
 void Block_manager_parent::register_erase_outcome(Event& event, enum status status) {
-	IO_has_completed_since_last_shortest_queue_search = true;
-
 	Address a = event.get_address();
 	a.valid = PAGE;
 	a.page = 0;
@@ -143,8 +165,7 @@ void Block_manager_parent::register_erase_outcome(Event& event, enum status stat
 		}
 	}
 
-	uint age_class = sort_into_age_class(a);
-	free_blocks[a.package][a.die][age_class].push_back(a);
+	add_free_block(a, sort_into_age_class(a));
 
 	num_free_pages += BLOCK_SIZE;
 	num_available_pages_for_new_writes += BLOCK_SIZE;
@@ -163,8 +184,13 @@ void Block_manager_parent::register_write_arrival(Event const& write) {
 
 }
 
-void Block_manager_parent::register_register_cleared() {
-	IO_has_completed_since_last_shortest_queue_search = true;
+void Block_manager_parent::register_register_cleared(Address const& die_address) {
+	mark_lun_for_update(die_address.package, die_address.die);
+}
+
+// Called whenever an IO is issued to a LUN, since this changes the finish times of the die and channel
+void Block_manager_parent::register_die_activity(Address const& die_address) {
+	mark_lun_for_update(die_address.package, die_address.die);
 }
 
 uint Block_manager_parent::sort_into_age_class(Address const& a) const {
@@ -182,8 +208,6 @@ void Block_manager_parent::increment_pointer(Address& pointer) {
 }
 
 void Block_manager_parent::register_write_outcome(Event const& event, enum status status) {
-	IO_has_completed_since_last_shortest_queue_search = true;
-
 	assert(num_free_pages > 0);
 	num_free_pages--;
 
@@ -197,6 +221,7 @@ void Block_manager_parent::register_write_outcome(Event const& event, enum statu
 	//printf("%d   %d\n", num_available_pages_for_new_writes, num_free_pages);
 	// if there are very few pages left, need to trigger emergency GC
 	if (num_free_pages <= BLOCK_SIZE && migrator->how_many_gc_operations_are_scheduled() == 0) {
+		StatisticsGatherer::get_global_instance()->num_gc_triggered_out_of_space++;
 		migrator->schedule_gc(event.get_current_time(), -1, -1, -1, -1);
 	}
 
@@ -204,17 +229,7 @@ void Block_manager_parent::register_write_outcome(Event const& event, enum statu
 	if (ba.compare(free_block_pointers[ba.package][ba.die]) >= BLOCK) {
 		increment_pointer(free_block_pointers[ba.package][ba.die]);
 		if (!has_free_pages(free_block_pointers[ba.package][ba.die])) {
-			if (PRINT_LEVEL > 1) {
-				printf("hot pointer "); free_block_pointers[ba.package][ba.die].print(); printf(" is out of space");
-			}
-			Address free_pointer = find_free_unused_block(ba.package, ba.die, YOUNG, event.get_current_time());
-			if (has_free_pages(free_pointer)) {
-				free_block_pointers[ba.package][ba.die] = free_pointer;
-			}
-			if (PRINT_LEVEL > 1) {
-				if (free_pointer.valid == NONE) printf(", and a new unused block could not be found.\n");
-				else printf(".\n");
-			}
+			handle_block_pointer_out_of_space(ba.package, ba.die, event.get_current_time());
 		}
 	}
 
@@ -224,12 +239,26 @@ void Block_manager_parent::register_write_outcome(Event const& event, enum statu
 	else {
 		Free_Space_Per_LUN_Meter::mark_new_space(ba, event.get_current_time());
 	}
+	update_gc_watermark(ba.package, ba.die);
 }
 
-void Block_manager_parent::trim(Event const& event) {
-	IO_has_completed_since_last_shortest_queue_search = true;
+// Called when the free block pointer of a LUN fills up. By default, the LUN gets a new block right away.
+void Block_manager_parent::handle_block_pointer_out_of_space(uint package, uint die, double time) {
+	if (PRINT_LEVEL > 1) {
+		printf("hot pointer "); free_block_pointers[package][die].print(); printf(" is out of space");
+	}
+	Address free_pointer = find_free_unused_block(package, die, YOUNG, time);
+	if (has_free_pages(free_pointer)) {
+		free_block_pointers[package][die] = free_pointer;
+	}
+	if (PRINT_LEVEL > 1) {
+		if (free_pointer.valid == NONE) printf(", and a new unused block could not be found.\n");
+		else printf(".\n");
+	}
 }
 
+void Block_manager_parent::trim(Event const& event) {}
+
 int Block_manager_parent::get_num_pointers_with_free_space() const {
 	int sum = 0;
 	for (int i = 0; i < SSD_SIZE; i++) {
@@ -253,34 +282,28 @@ int Block_manager_parent::get_num_free_blocks() const {
 }
 
 void Block_manager_parent::print_free_blocks() const {
-	for (int i = 0; i < SSD_SIZE; i++) {
-		for (int j = 0; j < PACKAGE_SIZE; j++) {
-			for (int k = 0; k < num_age_classes; k++) {
-				for (auto& q : free_blocks[i][j][k]) {
-					q.print();
-					printf("\n");
-				}
-			}
+	for (auto& pool : free_blocks) {
+		for (auto& q : pool) {
+			q.print();
+			printf("\n");
 		}
 	}
 }
 
-int Block_manager_parent::get_num_free_blocks(int package, int die) const {
-	int num_free_blocks = 0;
-	for (int i = 0; i < num_age_classes; i++) {
-		num_free_blocks += free_blocks[package][die][i].size();
-	}
-	return num_free_blocks;
+void Block_manager_parent::add_free_block(Address const& block_address, uint age_class) {
+	assert(age_class < num_age_classes);
+	int lun = block_address.package * PACKAGE_SIZE + block_address.die;
+	free_blocks[get_pool_id(block_address.package, block_address.die, age_class)].push_back(block_address);
+	non_empty_age_classes[lun] |= 1ULL << age_class;
+	num_free_blocks_per_lun[lun]++;
+	update_gc_watermark(block_address.package, block_address.die);
 }
 
 void Block_manager_parent::register_read_command_outcome(Event const& event, enum status status) {
-	IO_has_completed_since_last_shortest_queue_search = true;
 	assert(event.get_event_type() == READ_COMMAND);
 }
 
 void Block_manager_parent::register_read_transfer_outcome(Event const& event, enum status status) {
-	IO_has_completed_since_last_shortest_queue_search = true;
-	migrator->register_ECC_check_on(event.get_logical_address()); // An ECC check happens in a normal read-write GC operation
 	assert(event.get_event_type() == READ_TRANSFER);
 }
 
@@ -288,23 +311,28 @@ bool Block_manager_parent::can_write(Event const& write) const {
 	return num_available_pages_for_new_writes > 0 || write.is_garbage_collection_op();
 }
 
+// Called after an erase or when a LUN gets its first GC candidate. A GC request for a LUN below its watermark may have been
+// dropped, e.g. because the LUN was already being garbage-collected or had no victim, so such LUNs are asked again.
+// LUNs enter and leave the watermark set as blocks are allocated and erased, so this does not sweep the whole SSD.
 void Block_manager_parent::check_if_should_trigger_more_GC(Event const& event) {
 	if (num_free_pages <= BLOCK_SIZE) {
+		StatisticsGatherer::get_global_instance()->num_gc_triggered_out_of_space++;
 		migrator->schedule_gc(event.get_current_time(), -1, -1, -1, -1);
 	}
+	for (auto lun : luns_below_gc_watermark) {
+		StatisticsGatherer::get_global_instance()->num_gc_triggered_below_watermark++;
+		migrator->schedule_gc(event.get_current_time(), lun / PACKAGE_SIZE, lun % PACKAGE_SIZE, -1, -1);
+	}
+}
 
-	int num_luns_with_space = SSD_SIZE * PACKAGE_SIZE;
-	for (uint i = 0; i < SSD_SIZE; i++) {
-		for (uint j = 0; j < PACKAGE_SIZE; j++) {
-			if (!has_free_pages(free_block_pointers[i][j]) || get_num_free_blocks(i, j) < GREED_SCALE) {
-				migrator->schedule_gc(event.get_current_time(), i, j, -1, -1);
-			}
-			if (!has_free_pages(free_block_pointers[i][j])) {
-				num_luns_with_space--;
-			}
-		}
+void Block_manager_parent::update_gc_watermark(int package, int die) {
+	int lun = package * PACKAGE_SIZE + die;
+	if (!has_free_pages(free_block_pointers[package][die]) || get_num_free_blocks(package, die) < GREED_SCALE) {
+		luns_below_gc_watermark.insert(lun);
+	}
+	else {
+		luns_below_gc_watermark.erase(lun);
 	}
-	//printf("num_luns_with_space:  %d\n", num_luns_with_space);
 }
 
 // This function takes a vector of channels, each of each has a vector of dies
@@ -352,19 +380,53 @@ pair<bool, pair<int, int> > Block_manager_parent::get_free_block_pointer_with_sh
 }
 
 Address Block_manager_parent::get_free_block_pointer_with_shortest_IO_queue() {
-	pair<bool, pair<int, int> > best_die;
-	if (IO_has_completed_since_last_shortest_queue_search) {
-	    best_die = get_free_block_pointer_with_shortest_IO_queue(free_block_pointers);
-		last_get_free_block_pointer_with_shortest_IO_queue_result = best_die;
-		IO_has_completed_since_last_shortest_queue_search = false;
-	} else {
-		best_die = last_get_free_block_pointer_with_shortest_IO_queue_result;
-	}
-	if (!best_die.first) {
+	update_lun_availability();
+	if (package_availability.get_min_key() == numeric_limits<double>::max()) {
 		return Address();
-	} else {
-		return free_block_pointers[best_die.second.first][best_die.second.second];
 	}
+	int package = package_availability.get_min_index();
+	int die = die_availability[package].get_min_index();
+	return free_block_pointers[package][die];
+}
+
+void Block_manager_parent::mark_lun_for_update(int package, int die) {
+	update_gc_watermark(package, die);
+	if (!lun_needs_update[package][die]) {
+		lun_needs_update[package][die] = true;
+		luns_to_update.push_back(pair<int, int>(package, die));
+	}
+}
+
+void Block_manager_parent::update_lun_availability() {
+	for (auto lun : luns_to_update) {
+		int package = lun.first;
+		int die = lun.second;
+		lun_needs_update[package][die] = false;
+		Die* d = ssd->get_package(package)->get_die(die);
+		double never = numeric_limits<double>::max();
+		double die_finish_time = d->get_currently_executing_io_finish_time();
+		bool busy = d->register_is_busy();
+		bool can_write = has_free_pages(free_block_pointers[package][die]) && !busy;
+		die_availability[package].update(die, can_write ? die_finish_time : never);
+		idle_register_dies[package].update(die, busy ? never : die_finish_time);
+		busy_register_dies[package].update(die, busy ? die_finish_time : never);
+
+		double channel_finish_time = ssd->get_currently_executing_operation_finish_time(package);
+		double earliest_die = die_availability[package].get_min_key();
+		package_availability.update(package, earliest_die == never ? never : max(channel_finish_time, earliest_die));
+
+		double earliest_idle = idle_register_dies[package].get_min_key();
+		double earliest_busy = busy_register_dies[package].get_min_key();
+		double soonest_write = never;
+		if (earliest_idle != never) {
+			soonest_write = max(channel_finish_time, earliest_idle);
+		}
+		if (earliest_busy != never) {
+			soonest_write = min(soonest_write, max(channel_finish_time, earliest_busy) + BUS_DATA_DELAY + BUS_CTRL_DELAY);
+		}
+		soonest_write_per_package.update(package, soonest_write);
+	}
+	luns_to_update.clear();
 }
 
 bool Block_manager_parent::Copy_backs_in_progress(Address const& addr) {
@@ -372,7 +434,10 @@ bool Block_manager_parent::Copy_backs_in_progress(Address const& addr) {
 }
 
 // gives time until both the channel and die are clear
-double Block_manager_parent::in_how_long_can_this_event_be_scheduled(Address const& address, double event_time, event_type type) const {
+double Block_manager_parent::in_how_long_can_this_event_be_scheduled(Address const& address, double event_time, event_type type) {
+	if (type == WRITE) {
+		num_write_scheduling_queries++;
+	}
 	if (address.valid == NONE) {
 		return BUS_DATA_DELAY + BUS_CTRL_DELAY;
 	}
@@ -394,38 +459,20 @@ double Block_manager_parent::in_how_long_can_this_event_be_scheduled(Address con
 	return time;
 }
 
-double Block_manager_parent::in_how_long_can_this_write_be_scheduled(double current_time) const {
-	double min_execution_time = INFINITE;
-	for (int i = 0; i < SSD_SIZE; i++) {
-		double channel_finish_time = ssd->get_currently_executing_operation_finish_time(i);
-		for (int j = 0; j < PACKAGE_SIZE; j++) {
-			bool busy = ssd->get_package(i)->get_die(j)->register_is_busy();
-			double die_finish_time = ssd->get_package(i)->get_die(j)->get_currently_executing_io_finish_time();
-			double max_time = fmax(channel_finish_time, die_finish_time);
-			max_time += busy ? BUS_DATA_DELAY + BUS_CTRL_DELAY : 0;
-			min_execution_time = fmin(min_execution_time, max_time);
-		}
-	}
-	return fmax(min_execution_time - current_time, 0.0);
+// Gives the time until a write could start on some LUN, not considering whether the LUN has free space
+double Block_manager_parent::in_how_long_can_this_write_be_scheduled(double current_time) {
+	num_write_scheduling_queries++;
+	update_lun_availability();
+	return fmax(soonest_write_per_package.get_min_key() - current_time, 0.0);
 }
 
 double Block_manager_parent::in_how_long_can_this_write_be_scheduled2(double current_time) const {
 	return fmax(0.0, soonest_write_time - current_time);
 }
 
-void Block_manager_parent::update_next_possible_write_time() const {
-	double min_execution_time = INFINITE;
-	for (int i = 0; i < SSD_SIZE; i++) {
-		double channel_finish_time = ssd->get_currently_executing_operation_finish_time(i);
-		for (int j = 0; j < PACKAGE_SIZE; j++) {
-			bool busy = ssd->get_package(i)->get_die(j)->register_is_busy();
-			double die_finish_time = ssd->get_package(i)->get_die(j)->get_currently_executing_io_finish_time();
-			double max_time = fmax(channel_finish_time, die_finish_time);
-			max_time += busy ? BUS_DATA_DELAY + BUS_CTRL_DELAY : 0;
-			min_execution_time = fmin(min_execution_time, max_time);
-		}
-	}
-	soonest_write_time = min_execution_time;
+void Block_manager_parent::update_next_possible_write_time() {
+	update_lun_availability();
+	soonest_write_time = soonest_write_per_package.get_min_key();
 }
 
 bool Block_manager_parent::can_schedule_on_die(Address const& address, event_type type, uint app_io_id) const {
@@ -464,10 +511,9 @@ void Block_manager_parent::register_trim_making_gc_redundant(Event* trim) {
 
 // finds and returns a free block from anywhere in the SSD. Returns Address(0, NONE) is there is no such block
 Address Block_manager_parent::find_free_unused_block(double time) {
-	vector<int> order = Random_Order_Iterator::get_iterator(SSD_SIZE);
-	while (order.size() > 0) {
-		int index = order.back();
-		order.pop_back();
+	Random_Permutation order(SSD_SIZE);
+	while (order.has_next()) {
+		int index = order.next();
 		Address address = find_free_unused_block(index, time);
 		if (address.valid != NONE) {
 			return address;
@@ -478,10 +524,9 @@ Address Block_manager_parent::find_free_unused_block(double time) {
 
 Address Block_manager_parent::find_free_unused_block(uint package_id, double time) {
 	assert(package_id < SSD_SIZE);
-	vector<int> order = Random_Order_Iterator::get_iterator(PACKAGE_SIZE);
-	while (order.size() > 0) {
-		int index = order.back();
-		order.pop_back();
+	Random_Permutation order(PACKAGE_SIZE);
+	while (order.has_next()) {
+		int index = order.next();
 		Address address = find_free_unused_block(package_id, index, time);
 		if (address.valid != NONE) {
 			return address;
@@ -490,66 +535,71 @@ Address Block_manager_parent::find_free_unused_block(uint package_id, double tim
 	return Address(0, NONE);
 }
 
-// finds and returns a free block from a particular die in the SSD
+// finds and returns a free block from a particular die in the SSD. The age class is picked uniformly at random among the
+// non-empty ones, by selecting a random one of the set bits.
 Address Block_manager_parent::find_free_unused_block(uint package_id, uint die_id, double time) {
 	assert(package_id < SSD_SIZE && die_id < PACKAGE_SIZE);
-	vector<int> order = Random_Order_Iterator::get_iterator(num_age_classes);
-	while (order.size() > 0) {
-		int index = order.back();
-		order.pop_back();
-		Address address = find_free_unused_block(package_id, die_id, index, time);
-		if (address.valid != NONE) {
-			return address;
-		}
+	unsigned long long classes = non_empty_age_classes[package_id * PACKAGE_SIZE + die_id];
+	if (classes == 0) {
+		return find_free_unused_block(package_id, die_id, random_number_generator() % num_age_classes, time);
 	}
-	return Address(0, NONE);
+	int num_non_empty = __builtin_popcountll(classes);
+	if (num_non_empty < num_age_classes && GREED_SCALE > 0) {
+		StatisticsGatherer::get_global_instance()->num_gc_triggered_low_free_blocks++;
+		migrator->schedule_gc(time, package_id, die_id, -1, -1);	// the empty age classes are short of free blocks
+	}
+	for (int i = random_number_generator() % num_non_empty; i > 0; i--) {
+		classes &= classes - 1;
+	}
+	return find_free_unused_block(package_id, die_id, (uint)__builtin_ctzll(classes), time);
 }
 
 Address Block_manager_parent::find_free_unused_block(uint package_id, uint die_id, uint klass, double time) {
 	assert(package_id < SSD_SIZE && die_id < PACKAGE_SIZE && klass < num_age_classes);
 	Address to_return;
-	uint num_free_blocks_left = free_blocks[package_id][die_id][klass].size();
-	if (num_free_blocks_left > 0) {
-		to_return = free_blocks[package_id][die_id][klass].back();
-		free_blocks[package_id][die_id][klass].pop_back();
-		num_free_blocks_left--;
+	vector<Address>& pool = free_blocks[get_pool_id(package_id, die_id, klass)];
+	if (pool.size() > 0) {
+		int lun = package_id * PACKAGE_SIZE + die_id;
+		to_return = pool.back();
+		pool.pop_back();
+		num_free_blocks_per_lun[lun]--;
+		if (pool.empty()) {
+			non_empty_age_classes[lun] &= ~(1ULL << klass);
+		}
+		update_gc_watermark(package_id, die_id);
 		assert(has_free_pages(to_return));
 	}
-	if (to_return.valid != NONE &&  num_free_blocks_left == 0) {
-		//StateVisualiser::print_page_status();
-	}
-	if (num_free_blocks_left < GREED_SCALE) {
+	if (pool.size() < GREED_SCALE) {
+		StatisticsGatherer::get_global_instance()->num_gc_triggered_low_free_blocks++;
 		migrator->schedule_gc(time, package_id, die_id, -1, -1);
 	}
 	return to_return;
 }
 
 Address Block_manager_parent::find_free_unused_block(uint package, uint die, enum age age, double time) {
-	if (age == YOUNG) {
-		for (int i = 0; i < num_age_classes; i++) {
-			Address block = find_free_unused_block(package, die, i, time);
-			if (has_free_pages(block)) {
-				return block;
-			}
-		}
-	} else if (age == OLD) {
-		for (int i = num_age_classes - 1; i >= 0; i--) {
-			Address block = find_free_unused_block(package, die, i, time);
-			if (has_free_pages(block)) {
-				return block;
-			}
-		}
+	if (age != YOUNG && age != OLD) {
+		return Address();
 	}
-	return Address();
+	unsigned long long classes = non_empty_age_classes[package * PACKAGE_SIZE + die];
+	uint first = age == YOUNG ? 0 : num_age_classes - 1;
+	if (classes == 0) {
+		return find_free_unused_block(package, die, first, time);
+	}
+	uint klass = age == YOUNG ? __builtin_ctzll(classes) : 63 - __builtin_clzll(classes);
+	if (klass != first && GREED_SCALE > 0) {
+		StatisticsGatherer::get_global_instance()->num_gc_triggered_low_free_blocks++;
+		migrator->schedule_gc(time, package, die, -1, -1);	// the empty age classes that were skipped are short of free blocks
+	}
+	return find_free_unused_block(package, die, klass, time);
 }
 
 Address Block_manager_parent::find_free_unused_block(enum age age, double time) {
-	vector<int> order1 = Random_Order_Iterator::get_iterator(SSD_SIZE);
-	for (uint i = 0; i < SSD_SIZE; i++) {
-		int package = order1[i];
-		vector<int> order2 = Random_Order_Iterator::get_iterator(PACKAGE_SIZE);
-		for (uint j = 0; j < PACKAGE_SIZE; j++) {
-			int die = order2[j];
+	Random_Permutation order1(SSD_SIZE);
+	while (order1.has_next()) {
+		int package = order1.next();
+		Random_Permutation order2(PACKAGE_SIZE);
+		while (order2.has_next()) {
+			int die = order2.next();
 			Address block = find_free_unused_block(package, die, age, time);
 			if (has_free_pages(block)) {
 				return block;
@@ -563,9 +613,10 @@ void Block_manager_parent::return_unfilled_block(Address pba, double current_tim
 	if (has_free_pages(pba)) {
 		int age_class = sort_into_age_class(pba);
 		if (!give_to_block_pointers || has_free_pages(free_block_pointers[pba.package][pba.die])) {
-			free_blocks[pba.package][pba.die][age_class].push_back(pba);
+			add_free_block(pba, age_class);
 		} else {
 			free_block_pointers[pba.package][pba.die] = pba;
+			mark_lun_for_update(pba.package, pba.die);
 			Free_Space_Per_LUN_Meter::mark_new_space(pba, current_time);
 		}
 	}
@@ -574,6 +625,8 @@ void Block_manager_parent::return_unfilled_block(Address pba, double current_tim
 void Block_manager_parent::copy_state(Block_manager_parent* bm) {
 	free_block_pointers = bm->free_block_pointers;
 	free_blocks = bm->free_blocks;
+	non_empty_age_classes = bm->non_empty_age_classes;
+	num_free_blocks_per_lun = bm->num_free_blocks_per_lun;
 	all_blocks = bm->all_blocks;
 	num_age_classes = bm->num_age_classes;
 	num_free_pages = bm->num_free_pages;
@@ -586,6 +639,11 @@ void Block_manager_parent::copy_state(Block_manager_parent* bm) {
 	wl = bm->wl;
 	gc = bm->gc;
 	migrator = bm->migrator;
+	for (int i = 0; i < SSD_SIZE; i++) {
+		for (int j = 0; j < PACKAGE_SIZE; j++) {
+			mark_lun_for_update(i, j);
+		}
+	}
 }
 
 Block_manager_parent* Block_manager_parent::get_new_instance() {
@@ -598,6 +656,7 @@ Block_manager_parent* Block_manager_parent::get_new_instance() {
 		case 5: bm = new Block_Manager_Tag_Groups(); break;
 		case 6: bm = new Block_Manager_Groups(); break;
 		case 7: bm = new bm_gc_locality(); break;
+		case 8: bm = new Block_manager_superblock(); break;
 		default: bm = new Block_manager_parallel(); break;
 	}
 	return bm;
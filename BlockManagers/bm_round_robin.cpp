@@ -42,6 +42,7 @@ void Block_manager_roundrobin::register_erase_outcome(Event& event, enum status
 	// if there is no free pointer for this block, set it to this one.
 	if (!has_free_pages(free_block_pointers[a.package][a.die])) {
 		free_block_pointers[a.package][a.die] = find_free_unused_block(a.package, a.die);
+		update_gc_watermark(a.package, a.die);
 	}
 
 	check_if_should_trigger_more_GC(event);
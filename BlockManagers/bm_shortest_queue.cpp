@@ -31,6 +31,7 @@ void Block_manager_parallel::register_erase_outcome(Event& event, enum status st
 		if (has_free_pages(free_block_pointers[a.package][a.die])) {
 			Free_Space_Per_LUN_Meter::mark_new_space(a, event.get_current_time());
 		}
+		update_gc_watermark(a.package, a.die);
 	}
 }
 
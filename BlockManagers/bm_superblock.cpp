@@ -0,0 +1,180 @@
+/*
+ * bm_superblock.cpp
+ *
+ * Writes are striped over one open block per LUN, and a stripe is garbage-collected and erased as a unit.
+ */
+
+#include <new>
+#include <assert.h>
+#include <stdio.h>
+#include <stdexcept>
+#include <algorithm>
+#include "../ssd.h"
+
+using namespace ssd;
+
+Block_manager_superblock::Block_manager_superblock()
+:	Block_manager_parent(),
+	stripes(),
+	free_stripe_ids(),
+	stripe_of_block(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+	open_stripe(UNDEFINED),
+	blocks_awaiting_gc(),
+	cursor(0),
+	num_stripes_opened(0),
+	num_partial_stripes(0),
+	num_stripe_gcs(0)
+{}
+
+Block_manager_superblock::~Block_manager_superblock() {
+	printf("stripes opened\t%ld\n", num_stripes_opened);
+	printf("partial stripes\t%ld\n", num_partial_stripes);
+	printf("stripe GCs\t%ld\n", num_stripe_gcs);
+}
+
+// The blocks the parent hands out as the first free block pointers make up the first stripe
+void Block_manager_superblock::init(Ssd* ssd, FtlParent* ftl, IOScheduler* sched, Garbage_Collector* gc, Wear_Leveling_Strategy* wl, Migrator* migrator) {
+	Block_manager_parent::init(ssd, ftl, sched, gc, wl, migrator);
+	int id = get_new_stripe_id();
+	for (uint i = 0; i < SSD_SIZE; i++) {
+		for (uint j = 0; j < PACKAGE_SIZE; j++) {
+			Address block = free_block_pointers[i][j];
+			block.valid = BLOCK;
+			stripes[id].blocks.push_back(block);
+			stripe_of_block[block.get_block_id()] = id;
+		}
+	}
+	stripes[id].num_blocks_not_erased = stripes[id].blocks.size();
+	open_stripe = id;
+	num_stripes_opened++;
+}
+
+void Block_manager_superblock::register_write_outcome(Event const& event, enum status status) {
+	if (status == FAILURE) {
+		return;
+	}
+	Block_manager_parent::register_write_outcome(event, status);
+	Address a = event.get_address();
+	cursor = (a.die * SSD_SIZE + a.package + 1) % (SSD_SIZE * PACKAGE_SIZE);
+}
+
+void Block_manager_superblock::register_erase_outcome(Event& event, enum status status) {
+	Block_manager_parent::register_erase_outcome(event, status);
+	long block_id = event.get_address().get_block_id();
+	blocks_awaiting_gc.erase(block_id);
+	int id = stripe_of_block[block_id];
+	if (id != UNDEFINED) {
+		stripe_of_block[block_id] = UNDEFINED;
+		if (--stripes[id].num_blocks_not_erased == 0 && id != open_stripe) {
+			stripes[id] = stripe();
+			free_stripe_ids.push_back(id);
+		}
+	}
+	// the last stripe could not be opened because there were no free blocks
+	if (get_num_pointers_with_free_space() == 0) {
+		open_new_stripe(event.get_current_time());
+	}
+}
+
+// GC requests for the remaining blocks of a stripe may be dropped, e.g. if their LUN is already being garbage-collected
+void Block_manager_superblock::check_if_should_trigger_more_GC(Event const& event) {
+	Block_manager_parent::check_if_should_trigger_more_GC(event);
+	for (auto block_id : blocks_awaiting_gc) {
+		migrator->schedule_gc(event.get_current_time(), Address(block_id * BLOCK_SIZE, BLOCK), UNDEFINED);
+	}
+}
+
+// Garbage-collecting any block of a full stripe pulls in the rest of the stripe. The open stripe is left alone until it is full.
+bool Block_manager_superblock::may_garbage_collect_this_block(Block* block, double current_time) {
+	Address victim = Address(block->get_physical_address(), BLOCK);
+	int id = stripe_of_block[victim.get_block_id()];
+	if (id == UNDEFINED) {
+		return true;
+	}
+	if (id == open_stripe) {
+		return false;
+	}
+	stripe& s = stripes[id];
+	if (!s.being_garbage_collected) {
+		s.being_garbage_collected = true;
+		num_stripe_gcs++;
+		for (auto& b : s.blocks) {
+			if (b.get_block_id() != victim.get_block_id() && stripe_of_block[b.get_block_id()] == id) {
+				blocks_awaiting_gc.insert(b.get_block_id());
+				migrator->schedule_gc(current_time, b, UNDEFINED);
+			}
+		}
+	}
+	blocks_awaiting_gc.erase(victim.get_block_id());
+	return true;
+}
+
+// Returns the block of the next LUN in the stripe that still has free pages
+Address Block_manager_superblock::choose_best_address(Event& write) {
+	int num_luns = SSD_SIZE * PACKAGE_SIZE;
+	for (int i = 0; i < num_luns; i++) {
+		int lun = (cursor + i) % num_luns;
+		Address const& pointer = free_block_pointers[lun % SSD_SIZE][lun / SSD_SIZE];
+		if (has_free_pages(pointer)) {
+			return pointer;
+		}
+	}
+	return Address();
+}
+
+Address Block_manager_superblock::choose_any_address(Event const& write) {
+	return get_free_block_pointer_with_shortest_IO_queue();
+}
+
+// A LUN whose block fills up waits for the rest of the stripe, so the blocks of a stripe are written at about the same time
+void Block_manager_superblock::handle_block_pointer_out_of_space(uint package, uint die, double time) {
+	if (get_num_pointers_with_free_space() == 0) {
+		open_new_stripe(time);
+	}
+}
+
+// Takes a free block from every LUN. LUNs without a free block are left out of the stripe.
+void Block_manager_superblock::open_new_stripe(double time) {
+	int id = get_new_stripe_id();
+	stripe& s = stripes[id];
+	for (uint i = 0; i < SSD_SIZE; i++) {
+		for (uint j = 0; j < PACKAGE_SIZE; j++) {
+			Address pointer = find_free_unused_block(i, j, YOUNG, time);
+			if (!has_free_pages(pointer)) {
+				continue;
+			}
+			free_block_pointers[i][j] = pointer;
+			mark_lun_for_update(i, j);
+			Free_Space_Per_LUN_Meter::mark_new_space(pointer, time);
+			Address block = pointer;
+			block.valid = BLOCK;
+			s.blocks.push_back(block);
+			stripe_of_block[block.get_block_id()] = id;
+		}
+	}
+	if (open_stripe != UNDEFINED && stripes[open_stripe].num_blocks_not_erased == 0) {
+		stripes[open_stripe] = stripe();
+		free_stripe_ids.push_back(open_stripe);
+	}
+	if (s.blocks.empty()) {
+		free_stripe_ids.push_back(id);
+		open_stripe = UNDEFINED;
+		return;
+	}
+	s.num_blocks_not_erased = s.blocks.size();
+	open_stripe = id;
+	num_stripes_opened++;
+	if (s.blocks.size() < SSD_SIZE * PACKAGE_SIZE) {
+		num_partial_stripes++;
+	}
+}
+
+int Block_manager_superblock::get_new_stripe_id() {
+	if (free_stripe_ids.empty()) {
+		stripes.push_back(stripe());
+		return stripes.size() - 1;
+	}
+	int id = free_stripe_ids.back();
+	free_stripe_ids.pop_back();
+	return id;
+}
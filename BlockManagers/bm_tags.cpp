@@ -90,6 +90,7 @@ void Block_Manager_Tag_Groups::register_erase_outcome(Event& event, enum status
 
 	if (!has_free_pages(free_block_pointers[p][d])) {
 		free_block_pointers[p][d] = find_free_unused_block(p, d, event.get_current_time());
+		update_gc_watermark(p, d);
 	}
 }
 
@@ -467,7 +467,9 @@ void group::group_stats::print() const {
 }
 
 void group::register_write_outcome(Event const& event) {
-	mapping_pages_to_tags[event.get_logical_address()] = event.get_tag();
+	if (!mapping_pages_to_tags.empty()) {
+		mapping_pages_to_tags[event.get_logical_address()] = event.get_tag();
+	}
 	stats_gatherer.register_completed_event(event);
 	num_app_writes++;
 	if (event.get_address().page == 0) {
@@ -500,11 +502,10 @@ void group::register_erase_outcome(Event& event) {
 	//blocks_queue_per_die[a.package][a.die].erase()
 }
 
+// The least recently written block that is full. A block whose pages are all invalid is INACTIVE and is the cheapest victim.
 Block* group::get_gc_victim_LRU(int package, int die) const {
-	Block* b = blocks_queue_per_die[package][die].front();
-	Address a = Address(b->get_physical_address(), BLOCK);
-	for (int i = 0; i < blocks_queue_per_die[package][die].size(); i++) {
-		if (b->get_state() == ACTIVE && a.package == package && a.die == die) {
+	for (Block* b : blocks_queue_per_die[package][die]) {
+		if (b->get_state() == ACTIVE || b->get_state() == INACTIVE) {
 			return b;
 		}
 	}
@@ -16,10 +16,25 @@ Wear_Leveling_Strategy::Wear_Leveling_Strategy()
 	  num_erases_up_to_date(0),
 	  average_erase_cycle_time(0),
 	  max_age(1),
-	  age_distribution(),
+	  blocks_of_age(),
+	  position_in_age(),
+	  min_age(0),
 	  all_blocks(),
 	  random_number_generator(90),
-	  block_data(SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE, Block_data()) {
+	  block_data(SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE, Block_data()),
+	  page_tokens(BLOCK_SIZE),
+	  last_token_refill(0),
+	  wl_op_scheduled(false),
+	  wl_op_first_scheduled(0),
+	  wl_op_waiting_for_erase(false),
+	  waiting_wl_op(),
+	  num_retries_of_wl_op(0),
+	  num_wl_ops_per_lun(SSD_SIZE * PACKAGE_SIZE, 0),
+	  num_wl_ops(0), num_urgent_wl_ops(0), num_wl_pages(0), num_idle_deferrals(0), num_budget_deferrals(0), num_wl_retries(0),
+	  num_wl_ops_given_up(0), max_spread(0),
+	  total_wl_deferral_time(0),
+	  num_wl_ios(0), num_foreground_ios_during_wl(0), num_other_foreground_ios(0),
+	  wl_io_latency(0), foreground_latency_during_wl(0), other_foreground_latency(0) {
 
 }
 
@@ -29,16 +44,55 @@ Wear_Leveling_Strategy::Wear_Leveling_Strategy(Ssd* ssd, Migrator* migrator)
 	  num_erases_up_to_date(0),
 	  average_erase_cycle_time(0),
 	  max_age(1),
-	  age_distribution(),
+	  blocks_of_age(),
+	  position_in_age(),
+	  min_age(0),
 	  all_blocks(),
 	  random_number_generator(90),
-	  block_data(SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE, Block_data())
+	  block_data(SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE, Block_data()),
+	  page_tokens(BLOCK_SIZE),
+	  last_token_refill(0),
+	  wl_op_scheduled(false),
+	  wl_op_first_scheduled(0),
+	  wl_op_waiting_for_erase(false),
+	  waiting_wl_op(),
+	  num_retries_of_wl_op(0),
+	  num_wl_ops_per_lun(SSD_SIZE * PACKAGE_SIZE, 0),
+	  num_wl_ops(0), num_urgent_wl_ops(0), num_wl_pages(0), num_idle_deferrals(0), num_budget_deferrals(0), num_wl_retries(0),
+	  num_wl_ops_given_up(0), max_spread(0),
+	  total_wl_deferral_time(0),
+	  num_wl_ios(0), num_foreground_ios_during_wl(0), num_other_foreground_ios(0),
+	  wl_io_latency(0), foreground_latency_during_wl(0), other_foreground_latency(0)
 {
 	init();
 }
 
+Wear_Leveling_Strategy::~Wear_Leveling_Strategy() {
+	if (!ENABLE_WEAR_LEVELING) {
+		return;
+	}
+	printf("wear-leveling operations\t%ld\n", num_wl_ops);
+	printf("urgent wear-leveling operations\t%ld\n", num_urgent_wl_ops);
+	printf("wear-leveling migrations\t%ld\n", num_wl_pages);
+	printf("wear-leveling deferrals for idleness\t%ld\n", num_idle_deferrals);
+	printf("wear-leveling deferrals for budget\t%ld\n", num_budget_deferrals);
+	printf("wear-leveling retries\t%ld\n", num_wl_retries);
+	printf("wear-leveling operations given up\t%ld\n", num_wl_ops_given_up);
+	printf("wear-leveling avg deferral\t%f\n", num_wl_ops == 0 ? 0 : total_wl_deferral_time / num_wl_ops);
+	printf("wear-leveling avg IO latency\t%f\n", num_wl_ios == 0 ? 0 : wl_io_latency / num_wl_ios);
+	printf("application IOs during wear-leveling\t%ld\n", num_foreground_ios_during_wl);
+	printf("application avg latency during wear-leveling\t%f\n", num_foreground_ios_during_wl == 0 ? 0 : foreground_latency_during_wl / num_foreground_ios_during_wl);
+	printf("application avg latency otherwise\t%f\n", num_other_foreground_ios == 0 ? 0 : other_foreground_latency / num_other_foreground_ios);
+	printf("age spread\t%d\n", max_age - min_age);
+	printf("max age spread\t%d\n", max_spread);
+	// the spread can pass WEAR_LEVEL_MAX_SPREAD while urgent operations are under way, but should stay near it
+	if (max_spread > WEAR_LEVEL_MAX_SPREAD + WEAR_LEVEL_THRESHOLD) {
+		printf("warning: the age spread reached %d, over WEAR_LEVEL_MAX_SPREAD (%d)\n", max_spread, WEAR_LEVEL_MAX_SPREAD);
+	}
+}
+
 void Wear_Leveling_Strategy::init() {
-	age_distribution[0] = NUMBER_OF_ADDRESSABLE_BLOCKS();
+	blocks_of_age.push_back(vector<int>());
 	for (uint i = 0; i < SSD_SIZE; i++) {
 			Package* package = ssd->get_package(i);
 			for (uint j = 0; j < PACKAGE_SIZE; j++) {
@@ -47,6 +101,8 @@ void Wear_Leveling_Strategy::init() {
 					Plane* plane = die->get_plane(t);
 					for (uint b = 0; b < PLANE_SIZE; b++) {
 						Block* block = plane->get_block(b);
+						position_in_age.push_back(blocks_of_age[0].size());
+						blocks_of_age[0].push_back(all_blocks.size());
 						all_blocks.push_back(block);
 					}
 				}
@@ -55,14 +111,14 @@ void Wear_Leveling_Strategy::init() {
 }
 
 double Wear_Leveling_Strategy::get_min_age() const {
-	map<int, int>::const_iterator it = age_distribution.begin();
-	int age = (*it).first;
-	return age;
+	return min_age;
 }
 
 double Wear_Leveling_Strategy::get_normalised_age(uint age) const {
-	double min_age = get_min_age();
-	double normalized_age = (age - min_age) / (max_age - min_age);
+	if (max_age == min_age) {
+		return 0;
+	}
+	double normalized_age = (age - get_min_age()) / (max_age - get_min_age());
 	assert(normalized_age >= 0 && normalized_age <= 1);
 	return normalized_age;
 }
@@ -87,48 +143,141 @@ void Wear_Leveling_Strategy::register_erase_completion(Event const& event) {
 	data.last_erase_time = event.get_current_time();
 
 	average_erase_cycle_time = average_erase_cycle_time * 0.8 + 0.2 * time_since_last_erase;
-	int age = data.age - 1;
-	if (age_distribution.count(age - 1) == 1) {
-		age_distribution[age - 1]--;
-		age_distribution[age]++;
-		if (age_distribution[age - 1] == 0) {
-			age_distribution.erase(age - 1);
-		}
+
+	// the block moves from the bucket of its previous age to the next one
+	vector<int>& previous = blocks_of_age[data.age - 1];
+	int moved = previous.back();
+	previous[position_in_age[id]] = moved;
+	position_in_age[moved] = position_in_age[id];
+	previous.pop_back();
+	if (blocks_of_age.size() == data.age) {
+		blocks_of_age.push_back(vector<int>());
 	}
+	position_in_age[id] = blocks_of_age[data.age].size();
+	blocks_of_age[data.age].push_back(id);
+	while (blocks_of_age[min_age].empty()) {
+		min_age++;
+	}
+	max_spread = max(max_spread, max_age - min_age);
 
 	if (blocks_being_wl.count(b) > 0) {
 		blocks_being_wl.erase(b);
-		StatisticsGatherer::get_global_instance()->print();
+		num_wl_ops_per_lun[pba.package * PACKAGE_SIZE + pba.die]--;
 	}
 
-	// looking for gc candidates every single time to update the list. This is CPU expensive, so we want to make it more seldom in the future.
-	if (ENABLE_WEAR_LEVELING /* blocks_to_wl.size() == 0 */ && blocks_being_wl.size() < MAX_ONGOING_WL_OPS && max_age > get_min_age() + WEAR_LEVEL_THRESHOLD) {
-		blocks_to_wl.clear();
-		find_wl_candidates(event.get_current_time());
-		//StateVisualiser::print_block_ages();
-		//StatisticsGatherer::get_instance()->print();
+	if (wl_op_waiting_for_erase) {
+		wl_op_waiting_for_erase = false;
+		migrator->schedule_wear_leveling(event.get_current_time(), waiting_wl_op);
+		return;
 	}
 
-	if (blocks_to_wl.size() > 0 && blocks_being_wl.size() < MAX_ONGOING_WL_OPS) {
-		int random_index = random_number_generator() % blocks_to_wl.size();
-		set<Block*>::iterator i = blocks_to_wl.begin();
-		advance(i, random_index);
-		Block* target = *i;
+	if (!ENABLE_WEAR_LEVELING || wl_op_scheduled || (blocks_being_wl.size() >= MAX_ONGOING_WL_OPS && !is_urgent()) || max_age <= get_min_age() + WEAR_LEVEL_THRESHOLD) {
+		return;
+	}
+	Block* target = choose_wl_candidate(event.get_current_time());
+	if (target != NULL) {
 		Address addr = Address(target->get_physical_address(), BLOCK);
 		if (PRINT_LEVEL > 1) {
 			printf("Scheduling WL in "); addr.print(); printf("\n");
 		}
-		migrator->schedule_gc(event.get_current_time(), addr.package, addr.die, addr.block, -1);
+		wl_op_scheduled = true;
+		wl_op_first_scheduled = event.get_current_time();
+		num_retries_of_wl_op = 0;
+		migrator->schedule_wear_leveling(event.get_current_time(), addr);
+	}
+}
+
+// Called by the Migrator when a wear-leveling operation is about to start. Unless the age spread has reached
+// WEAR_LEVEL_MAX_SPREAD, the operation waits until the LUN of its block has been idle for WEAR_LEVELING_IDLE_WINDOW.
+// It then waits until the page budget covers the valid pages of the block. A waiting operation is scheduled again.
+// The pages are taken from the budget once the operation starts, in schedule_wear_leveling_op. An urgent operation
+// does not wait, and leaves the budget in debt, to be paid back before the next operation that is not urgent.
+bool Wear_Leveling_Strategy::may_wear_level(Address const& block_address, double time) {
+	Block* victim = ssd->get_package(block_address.package)->get_die(block_address.die)->get_plane(block_address.plane)->get_block(block_address.block);
+	if (WEAR_LEVELING_PAGES_PER_SECOND > 0) {
+		page_tokens = min(page_tokens + (time - last_token_refill) * WEAR_LEVELING_PAGES_PER_SECOND / 1000000, (double)BLOCK_SIZE);
+		last_token_refill = time;
+	}
+	if (is_urgent()) {
+		return true;
+	}
+	double start_time = time;
+	if (WEAR_LEVELING_IDLE_WINDOW > 0) {
+		double idle_time = migrator->get_last_foreground_activity(block_address.package, block_address.die) + WEAR_LEVELING_IDLE_WINDOW;
+		if (time < idle_time) {
+			start_time = idle_time;
+			num_idle_deferrals++;
+		}
+	}
+	if (start_time == time && WEAR_LEVELING_PAGES_PER_SECOND > 0 && page_tokens < victim->get_pages_valid()) {
+		start_time = time + (victim->get_pages_valid() - page_tokens) * 1000000 / WEAR_LEVELING_PAGES_PER_SECOND;
+		num_budget_deferrals++;
+	}
+	if (start_time > time) {
+		migrator->schedule_wear_leveling(start_time, block_address);
+		return false;
 	}
+	return true;
 }
 
-bool Wear_Leveling_Strategy::schedule_wear_leveling_op(Block* victim) {
-	if (blocks_being_wl.size() >= MAX_ONGOING_WL_OPS) {
+// Wear-leveling is urgent once the age spread reaches WEAR_LEVEL_MAX_SPREAD. It then ignores the idle window, the page
+// budget, MAX_ONGOING_WL_OPS and the GC budgets in the Migrator, and takes blocks erased as recently as one erase cycle ago.
+bool Wear_Leveling_Strategy::is_urgent() const {
+	return max_age - min_age >= WEAR_LEVEL_MAX_SPREAD;
+}
+
+// Called by the Migrator when a wear-leveling operation cannot start because of the GC budgets, free space or the block
+// manager. It is tried again at the next erase, which is what lifts these limits, unless its block has been erased in the
+// meantime. After too many retries the operation is given up, and a fresh candidate is chosen at a later erase.
+void Wear_Leveling_Strategy::retry_wear_leveling(Address const& block_address, double time) {
+	const int max_retries = 16;
+	Block* victim = ssd->get_package(block_address.package)->get_die(block_address.die)->get_plane(block_address.plane)->get_block(block_address.block);
+	if (victim->get_state() == FREE || victim->get_state() == PARTIALLY_FREE) {
+		wl_op_scheduled = false;
+		return;
+	}
+	if (++num_retries_of_wl_op > max_retries) {
+		num_wl_ops_given_up++;
+		wl_op_scheduled = false;
+		return;
+	}
+	num_wl_retries++;
+	wl_op_waiting_for_erase = true;
+	waiting_wl_op = block_address;
+}
+
+void Wear_Leveling_Strategy::register_event_completion(Event const& event) {
+	event_type type = event.get_event_type();
+	if (!ENABLE_WEAR_LEVELING || event.get_noop() || (type != WRITE && type != READ_TRANSFER && type != COPY_BACK) || event.get_address().valid < DIE) {
+		return;
+	}
+	if (event.is_wear_leveling_op()) {
+		num_wl_ios++;
+		wl_io_latency += event.get_latency();
+	} else if (event.is_original_application_io() && num_wl_ops_per_lun[event.get_address().package * PACKAGE_SIZE + event.get_address().die] > 0) {
+		num_foreground_ios_during_wl++;
+		foreground_latency_during_wl += event.get_latency();
+	} else if (event.is_original_application_io()) {
+		num_other_foreground_ios++;
+		other_foreground_latency += event.get_latency();
+	}
+}
+
+bool Wear_Leveling_Strategy::schedule_wear_leveling_op(Block* victim, double time) {
+	wl_op_scheduled = false;
+	if (blocks_being_wl.size() >= MAX_ONGOING_WL_OPS && !is_urgent()) {
 		return false;
 	} else {
 		blocks_being_wl.insert(victim);
+		Address addr = Address(victim->get_physical_address(), BLOCK);
+		num_wl_ops_per_lun[addr.package * PACKAGE_SIZE + addr.die]++;
+		page_tokens -= victim->get_pages_valid();
+		num_wl_ops++;
+		num_urgent_wl_ops += is_urgent();
+		num_wl_pages += victim->get_pages_valid();
+		total_wl_deferral_time += time - wl_op_first_scheduled;
 	}
-	blocks_to_wl.erase(victim);
+	return true;
 }
 
 /*void Wear_Leveling_Strategy::update_blocks_with_min_age(uint min_age) {
@@ -141,19 +290,39 @@ bool Wear_Leveling_Strategy::schedule_wear_leveling_op(Block* victim) {
 	}
 }*/
 
-void Wear_Leveling_Strategy::find_wl_candidates(double current_time) {
-	for (uint i = 0; i < all_blocks.size(); i++) {
-		Block* b = all_blocks[i];
-		Block_data& data = block_data[i];
-		double normalised_age = get_normalised_age(data.age);
-		double time_since_last_erase = current_time - data.last_erase_time;
-		if (b->get_state() == ACTIVE && normalised_age < 0.1 && time_since_last_erase  > average_erase_cycle_time * 10) {
-			blocks_to_wl.insert(b);
+// A candidate is a young block, with a normalised age under 0.1, that holds data and has not been erased for ten erase cycles,
+// or for one when wear-leveling is urgent.
+// Young blocks are sampled from the buckets of the youngest ages, and the first that qualifies is taken. There are few young
+// ages, so sampling does not depend on the number of blocks. If every sample misses, the young buckets are scanned, so that
+// no candidate is missed while one exists.
+Block* Wear_Leveling_Strategy::choose_wl_candidate(double current_time) {
+	const int num_samples = 16;
+	long num_young_blocks = 0;
+	for (int age = min_age; age < blocks_of_age.size() && get_normalised_age(age) < 0.1; age++) {
+		num_young_blocks += blocks_of_age[age].size();
+	}
+	for (int i = 0; i < num_samples && num_young_blocks > 0; i++) {
+		long index = random_number_generator() % num_young_blocks;
+		int age = min_age;
+		for (; index >= (long)blocks_of_age[age].size(); age++) {
+			index -= blocks_of_age[age].size();
+		}
+		int id = blocks_of_age[age][index];
+		if (is_wl_candidate(id, current_time)) {
+			return all_blocks[id];
 		}
 	}
-	if (PRINT_LEVEL > 1) {
-		printf("%d elements inserted into WL queue\n", blocks_to_wl.size());
+	for (int age = min_age; age < blocks_of_age.size() && get_normalised_age(age) < 0.1; age++) {
+		for (uint i = 0; i < blocks_of_age[age].size(); i++) {
+			if (is_wl_candidate(blocks_of_age[age][i], current_time)) {
+				return all_blocks[blocks_of_age[age][i]];
+			}
+		}
 	}
+	return NULL;
 }
 
-
+bool Wear_Leveling_Strategy::is_wl_candidate(int block_id, double current_time) const {
+	double min_idle_time = average_erase_cycle_time * (is_urgent() ? 1 : 10);
+	return all_blocks[block_id]->get_state() == ACTIVE && current_time - block_data[block_id].last_erase_time > min_idle_time;
+}
@@ -0,0 +1,136 @@
+#include "../ssd.h"
+#include <chrono>
+using namespace ssd;
+
+// Compares bloom_filter with blocked_bloom_filter under the access patterns of the two Bloom filter based
+// temperature detectors, and times BloomFilter_Page_Hotness_Measurer as a whole.
+
+static double seconds_since(chrono::high_resolution_clock::time_point start) {
+	return chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+}
+
+static bloom_parameters get_parameters(ulong projected_element_count, double false_positive_probability) {
+	bloom_parameters parameters;
+	parameters.projected_element_count = projected_element_count;
+	parameters.false_positive_probability = false_positive_probability;
+	parameters.compute_optimal_parameters();
+	return parameters;
+}
+
+// Fills a filter with its projected number of keys and measures how often keys that were never inserted are found
+template <class filter_type>
+double false_positive_rate(bloom_parameters const& parameters) {
+	filter_type filter(parameters);
+	for (ulong key = 0; key < parameters.projected_element_count; key++) {
+		filter.insert(key * 7919);
+	}
+	long hits = 0, num_queries = 1000000;
+	for (long i = 0; i < num_queries; i++) {
+		hits += filter.contains(i * 7919 + 1);
+	}
+	return hits / (double) num_queries;
+}
+
+// BloomFilter_Page_Hotness_Measurer: every write looks for the newest filter without the page and inserts it there,
+// computes the hot data index over all filters, and the oldest filter is cleared every IOs_before_decay writes.
+template <class filter_type>
+double hotness_measurer_pattern(bloom_parameters const& parameters, int num_filters, int IOs_before_decay, long num_ios, long range) {
+	vector<filter_type> filters(num_filters, filter_type(parameters));
+	MTRand_int32 random(1);
+	int oldest = 0;
+	double checksum = 0;
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	for (long i = 0; i < num_ios; i++) {
+		ulong key = random() % range;
+		if (i % IOs_before_decay == 0) {
+			filters[oldest].clear();
+			oldest = (oldest + 1) % num_filters;
+		}
+		int pos = oldest;
+		do {
+			pos = (pos + num_filters - 1) % num_filters;
+			if (filters[pos].contains(key)) continue;
+			filters[pos].insert(key);
+			break;
+		} while (pos != oldest);
+		for (int j = 0; j < num_filters; j++) {
+			checksum += filters[(oldest + j) % num_filters].contains(key) * (j + 1);
+		}
+	}
+	double time = seconds_since(start);
+	if (checksum < 0) printf("%f\n", checksum);
+	return time;
+}
+
+// bloom_detector: every write counts the filters of its group that hold the page and inserts it into the newest one.
+// The oldest filter is dropped and a new one created once a group has seen as many writes as it has pages.
+template <class filter_type>
+double bloom_detector_pattern(bloom_parameters const& parameters, int num_groups, int num_filters, long num_ios, long range) {
+	vector<vector<filter_type*> > groups(num_groups, vector<filter_type*>(num_filters, (filter_type*)NULL));
+	vector<long> writes(num_groups, 0);
+	for (int g = 0; g < num_groups; g++) {
+		groups[g][0] = new filter_type(parameters);
+	}
+	MTRand_int32 random(2);
+	long hits = 0;
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	for (long i = 0; i < num_ios; i++) {
+		ulong key = random() % range;
+		vector<filter_type*>& filters = groups[key % num_groups];
+		for (int j = num_filters - 1; j >= 0; j--) {
+			hits += filters[j] != NULL && filters[j]->contains(key);
+		}
+		filters[0]->insert(key);
+		if (++writes[key % num_groups] == (long)parameters.projected_element_count) {
+			writes[key % num_groups] = 0;
+			delete filters.back();
+			for (int j = num_filters - 1; j >= 1; j--) {
+				filters[j] = filters[j - 1];
+			}
+			filters[0] = new filter_type(parameters);
+		}
+	}
+	double time = seconds_since(start);
+	for (auto& filters : groups) {
+		for (auto f : filters) {
+			delete f;
+		}
+	}
+	if (hits < 0) printf("%ld\n", hits);
+	return time;
+}
+
+int main() {
+	set_small_SSD_config();
+	long num_ios = 4000000;
+
+	bloom_parameters hotness = get_parameters(512, 0.01);
+	printf("hotness measurer filters (512 keys, 1%% false positives)\n");
+	printf("false positive rate\tbloom_filter\t%f\tblocked_bloom_filter\t%f\n",
+			false_positive_rate<bloom_filter>(hotness), false_positive_rate<blocked_bloom_filter>(hotness));
+	double old_time = hotness_measurer_pattern<bloom_filter>(hotness, 4, 512, num_ios, 4096);
+	double new_time = hotness_measurer_pattern<blocked_bloom_filter>(hotness, 4, 512, num_ios, 4096);
+	printf("ns per write\tbloom_filter\t%f\tblocked_bloom_filter\t%f\n\n", old_time * 1e9 / num_ios, new_time * 1e9 / num_ios);
+
+	bloom_parameters detector = get_parameters(20000, bloom_detector::bloom_false_positive_probability);
+	printf("bloom_detector filters (20000 keys, %.0f%% false positives)\n", bloom_detector::bloom_false_positive_probability * 100);
+	printf("false positive rate\tbloom_filter\t%f\tblocked_bloom_filter\t%f\n",
+			false_positive_rate<bloom_filter>(detector), false_positive_rate<blocked_bloom_filter>(detector));
+	old_time = bloom_detector_pattern<bloom_filter>(detector, 10, bloom_detector::num_filters, num_ios, 1000000);
+	new_time = bloom_detector_pattern<blocked_bloom_filter>(detector, 10, bloom_detector::num_filters, num_ios, 1000000);
+	printf("ns per write\tbloom_filter\t%f\tblocked_bloom_filter\t%f\n\n", old_time * 1e9 / num_ios, new_time * 1e9 / num_ios);
+
+	BloomFilter_Page_Hotness_Measurer measurer;
+	MTRand_int32 random(3);
+	long num_events = 1000000, num_hot = 0;
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	for (long i = 0; i < num_events; i++) {
+		Event event(WRITE, random() % 4096, 1, 0);
+		event.set_original_application_io(true);
+		event.set_address(Address(random() % SSD_SIZE, random() % PACKAGE_SIZE, 0, 0, 0, PAGE));
+		measurer.register_event(event);
+		num_hot += measurer.get_write_hotness(event.get_logical_address()) == WRITE_HOT;
+	}
+	printf("BloomFilter_Page_Hotness_Measurer\tns per write\t%f\thot writes\t%ld\n", seconds_since(start) * 1e9 / num_events, num_hot);
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include "../ssd.h"
+#include <chrono>
+using namespace ssd;
+
+// A garbage-collection heavy workload on LUNs with many blocks, to time how long the simulator spends choosing victims.
+// The logical address space is written sequentially once and then overwritten with random writes, which keeps
+// garbage-collection busy. With skew, 90% of the random writes go to 10% of the logical address space.
+// Usage: gc_benchmark [blocks per LUN] [random writes] [GARBAGE_COLLECTION_POLICY] [skew (0 or 1)]
+
+class GC_Heavy_Workload : public Workload_Definition {
+public:
+	GC_Heavy_Workload(long num_random_writes, bool skew) : num_random_writes(num_random_writes), skew(skew) {}
+	vector<Thread*> generate() {
+		Simple_Thread* fill = new Asynchronous_Sequential_Writer(min_lba, max_lba);
+		fill->set_io_size(1);
+		if (skew) {
+			long boundary = min_lba + (max_lba - min_lba) / 10;
+			Simple_Thread* hot = new Asynchronous_Random_Writer(min_lba, boundary, 7);
+			hot->set_num_ios(num_random_writes * 9 / 10);
+			Simple_Thread* cold = new Asynchronous_Random_Writer(boundary + 1, max_lba, 8);
+			cold->set_num_ios(num_random_writes / 10);
+			fill->add_follow_up_thread(hot);
+			fill->add_follow_up_thread(cold);
+		} else {
+			Simple_Thread* random_writes = new Asynchronous_Random_Writer(min_lba, max_lba, 7);
+			random_writes->set_num_ios(num_random_writes);
+			fill->add_follow_up_thread(random_writes);
+		}
+		vector<Thread*> threads;
+		threads.push_back(fill);
+		return threads;
+	}
+private:
+	long num_random_writes;
+	bool skew;
+};
+
+static long sum(vector<vector<uint> > const& per_LUN) {
+	long total = 0;
+	for (auto const& package : per_LUN) {
+		for (uint num : package) {
+			total += num;
+		}
+	}
+	return total;
+}
+
+int main(int argc, char** argv) {
+	set_small_SSD_config();
+	SSD_SIZE = 2;
+	PACKAGE_SIZE = 2;
+	PLANE_SIZE = argc > 1 ? atoi(argv[1]) : 4096;
+	BLOCK_SIZE = 32;
+	OVER_PROVISIONING_FACTOR = 0.8;
+	PRINT_LEVEL = 0;
+	long num_random_writes = argc > 2 ? atol(argv[2]) : NUMBER_OF_ADDRESSABLE_PAGES();
+	GARBAGE_COLLECTION_POLICY = argc > 3 ? atoi(argv[3]) : 0;
+	bool skew = argc > 4 && atoi(argv[4]) != 0;
+
+	Experiment::create_base_folder("/gc_benchmark_output/");
+	Experiment* e = new Experiment();
+	GC_Heavy_Workload* workload = new GC_Heavy_Workload(num_random_writes, skew);
+	e->set_workload(workload);
+	e->set_io_limit(INFINITE);
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	e->run("gc_benchmark");
+	double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+	StatisticsGatherer* stats = StatisticsGatherer::get_global_instance();
+	long gc_writes = sum(stats->num_gc_writes_per_LUN_destination);
+	printf("gc policy\t%d\n", GARBAGE_COLLECTION_POLICY);
+	printf("host writes\t%ld\n", stats->total_writes());
+	printf("gc writes\t%ld\n", gc_writes);
+	printf("write amplification\t%f\n", stats->total_writes() == 0 ? 0 : (stats->total_writes() + gc_writes) / (double)stats->total_writes());
+	printf("blocks per LUN\t%d\n", PLANE_SIZE * DIE_SIZE);
+	printf("random writes\t%ld\n", num_random_writes);
+	printf("simulated time\t%f\n", Free_Space_Meter::get_current_time());
+	printf("wall time (s)\t%f\n", seconds);
+	delete workload;
+	return 0;
+}
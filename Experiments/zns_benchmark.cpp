@@ -0,0 +1,96 @@
+#include "../ssd.h"
+#include <chrono>
+#include <algorithm>
+using namespace ssd;
+
+// Compares the zoned FTL with the page-mapped FTL on the same geometry. Two Zoned_Log_Writers run at the same time, each
+// writing its part of the logical address space as a circular log of zones. The hot log covers a fifth of the space and
+// gets 80% of the writes. On ZNS each zone holds one log and is reset before it is reused, so nothing is ever migrated.
+// On the page FTL the logs are overwritten without trims, as a conventional drive would see them, and its blocks mix
+// pages of both logs, which garbage-collection has to migrate. The write amplification and the latency percentiles of
+// the writes are printed.
+// Usage: zns_benchmark [FTL_DESIGN (0 for page, 4 for ZNS)] [blocks per LUN] [writes] [blocks per zone]
+
+class Latency_Recording_Zoned_Log_Writer : public Zoned_Log_Writer {
+public:
+	Latency_Recording_Zoned_Log_Writer(long min_LBA, long max_LBA, int max_outstanding_ios, long num_ios, bool trim_on_reset, vector<double>& latencies)
+		: Zoned_Log_Writer(min_LBA, max_LBA, max_outstanding_ios, num_ios, false, trim_on_reset), latencies(latencies) {}
+	void handle_event_completion(Event* event) {
+		if (event->get_event_type() == WRITE) {
+			latencies.push_back(event->get_current_time() - event->get_start_time());
+		}
+		Zoned_Log_Writer::handle_event_completion(event);
+	}
+private:
+	vector<double>& latencies;
+};
+
+class Zoned_Log_Workload : public Workload_Definition {
+public:
+	Zoned_Log_Workload(long num_writes, bool trim_on_reset, vector<double>& latencies) : num_writes(num_writes), trim_on_reset(trim_on_reset), latencies(latencies) {}
+	vector<Thread*> generate() {
+		long boundary = min_lba + (max_lba - min_lba) / 5;
+		vector<Thread*> threads;
+		threads.push_back(new Latency_Recording_Zoned_Log_Writer(min_lba, boundary, 8, num_writes * 4 / 5, trim_on_reset, latencies));
+		threads.push_back(new Latency_Recording_Zoned_Log_Writer(boundary, max_lba, 8, num_writes / 5, trim_on_reset, latencies));
+		return threads;
+	}
+private:
+	long num_writes;
+	bool trim_on_reset;
+	vector<double>& latencies;
+};
+
+static long sum(vector<vector<uint> > const& per_LUN) {
+	long total = 0;
+	for (auto const& package : per_LUN) {
+		for (uint num : package) {
+			total += num;
+		}
+	}
+	return total;
+}
+
+static double percentile(vector<double> const& sorted, double p) {
+	return sorted.empty() ? 0 : sorted[min((size_t)(p * sorted.size()), sorted.size() - 1)];
+}
+
+int main(int argc, char** argv) {
+	set_small_SSD_config();
+	SSD_SIZE = 2;
+	PACKAGE_SIZE = 2;
+	FTL_DESIGN = argc > 1 ? atoi(argv[1]) : 0;
+	PLANE_SIZE = argc > 2 ? atoi(argv[2]) : 256;
+	BLOCK_SIZE = 32;
+	OVER_PROVISIONING_FACTOR = 0.8;
+	PRINT_LEVEL = 0;
+	long num_writes = argc > 3 ? atol(argv[3]) : NUMBER_OF_ADDRESSABLE_PAGES() * 4;
+	ZNS::BLOCKS_PER_ZONE = argc > 4 ? atoi(argv[4]) : 4;
+
+	vector<double> latencies;
+	Experiment::create_base_folder("/zns_benchmark_output/");
+	Experiment* e = new Experiment();
+	Zoned_Log_Workload* workload = new Zoned_Log_Workload(num_writes, FTL_DESIGN == 4, latencies);
+	e->set_workload(workload);
+	e->set_io_limit(INFINITE);
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	e->run("zns_benchmark");
+	double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+	StatisticsGatherer* stats = StatisticsGatherer::get_global_instance();
+	long gc_writes = sum(stats->num_gc_writes_per_LUN_destination);
+	sort(latencies.begin(), latencies.end());
+	printf("FTL design\t%d\n", FTL_DESIGN);
+	printf("zone size (pages)\t%ld\n", ZNS::get_zone_size());
+	printf("writes\t%ld\n", num_writes);
+	printf("write amplification\t%f\n", stats->total_writes() == 0 ? 0 : (stats->total_writes() + gc_writes) / (double)stats->total_writes());
+	printf("erases\t%ld\n", sum(stats->num_erases_per_LUN));
+	printf("write latency p50\t%f\n", percentile(latencies, 0.5));
+	printf("write latency p99\t%f\n", percentile(latencies, 0.99));
+	printf("write latency p99.9\t%f\n", percentile(latencies, 0.999));
+	printf("write latency max\t%f\n", latencies.empty() ? 0 : latencies.back());
+	printf("simulated time\t%f\n", Free_Space_Meter::get_current_time());
+	printf("wall time (s)\t%f\n", seconds);
+	delete workload;
+	return 0;
+}
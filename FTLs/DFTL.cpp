@@ -7,11 +7,20 @@
 using namespace ssd;
 int DFTL::ENTRIES_PER_TRANSLATION_PAGE = 1024;
 bool DFTL::SEPERATE_MAPPING_PAGES = true;
+int DFTL::PREFETCH_DEPTH = 0;
+int DFTL::HMB_TRANSLATION_PAGES = 0;
+double DFTL::HMB_LATENCY = 1;
 
 DFTL::DFTL(Ssd *ssd, Block_manager_parent* bm) :
 		flash_resident_page_ftl(ssd, bm),
 		ongoing_mapping_operations(),
 		application_ios_waiting_for_translation(),
+		prefetches_in_flight(),
+		prefetch_buffer(),
+		unused_prefetches(),
+		read_detector(new Sequential_Pattern_Detector(SEQUENTIAL_LOCALITY_THRESHOLD)),
+		host_memory_buffer(),
+		host_memory_buffer_index(),
 		mapping_pages(NUMBER_OF_ADDRESSABLE_PAGES() / ENTRIES_PER_TRANSLATION_PAGE)
 {
 	IS_FTL_PAGE_MAPPING = true;
@@ -20,31 +29,45 @@ DFTL::DFTL(Ssd *ssd, Block_manager_parent* bm) :
 DFTL::DFTL() :
 		flash_resident_page_ftl(),
 		ongoing_mapping_operations(),
-		application_ios_waiting_for_translation()
+		application_ios_waiting_for_translation(),
+		prefetches_in_flight(),
+		prefetch_buffer(),
+		unused_prefetches(),
+		read_detector(new Sequential_Pattern_Detector(SEQUENTIAL_LOCALITY_THRESHOLD)),
+		host_memory_buffer(),
+		host_memory_buffer_index()
 {
 	IS_FTL_PAGE_MAPPING = true;
 }
 
 DFTL::~DFTL(void)
 {
-	delete cache;
 	assert(application_ios_waiting_for_translation.size() == 0);
 	print();
+	delete cache;
+	delete read_detector;
 }
 
 
 void DFTL::read(Event *event) {
 
 	long la = event->get_logical_address();
+	// find which translation page is the logical address is on
+	long translation_page_id = la / ENTRIES_PER_TRANSLATION_PAGE;
+
+	if (PREFETCH_DEPTH > 0) {
+		sequential_writes_tracking const& stream = read_detector->register_event(la, event->get_current_time());
+		if (stream.counter >= SEQUENTIAL_LOCALITY_THRESHOLD) {
+			prefetch_translation_pages(translation_page_id, event->get_current_time());
+		}
+	}
+
 	// If the logical address is in the cached mapping table, submit the IO
 	if (cache->register_read_arrival(event)) {
 		scheduler->schedule_event(event);
 		return;
 	}
 
-	// find which translation page is the logical address is on
-	long translation_page_id = la / ENTRIES_PER_TRANSLATION_PAGE;
-
 	// If the mapping entry does not exist in cache and there is no translation page in flash, cancel the read
 	if (page_mapping->get_physical_address(la).valid == NONE) {
 		assert(page_mapping->get_physical_address(la).valid == NONE);
@@ -53,16 +76,101 @@ void DFTL::read(Event *event) {
 		return;
 	}
 
+	// If the translation page was prefetched, the mapping entry can be taken from the prefetch buffer without a mapping read
+	if (find(prefetch_buffer.begin(), prefetch_buffer.end(), translation_page_id) != prefetch_buffer.end()) {
+		register_prefetch_hit(translation_page_id);
+		cache->handle_read_dependency(event);
+		scheduler->schedule_event(event);
+		try_clear_space_in_mapping_cache(event->get_current_time());
+		return;
+	}
+
+	// If the translation page is in the Host Memory Buffer, the mapping entry is fetched over PCIe instead of from flash
+	if (ongoing_mapping_operations.count(NUMBER_OF_ADDRESSABLE_PAGES() - translation_page_id) == 0 && lookup_host_memory_buffer(translation_page_id, event)) {
+		cache->handle_read_dependency(event);
+		scheduler->schedule_event(event);
+		try_clear_space_in_mapping_cache(event->get_current_time());
+		return;
+	}
+
 	// If there is no mapping IO currently targeting the translation page, create on. Otherwise, invoke current event when ongoing mapping IO finishes.
 	if (ongoing_mapping_operations.count(NUMBER_OF_ADDRESSABLE_PAGES() - translation_page_id) == 1) {
 		application_ios_waiting_for_translation[translation_page_id].push_back(event);
+		if (prefetches_in_flight.count(translation_page_id) == 1) {
+			register_prefetch_hit(translation_page_id);
+		} else {
+			dftl_stats.num_demand_misses++;
+		}
 	}
 	else {
 		//printf("creating mapping read %d for app write %d\n", translation_page_id, event->get_logical_address());
 		create_mapping_read(translation_page_id, event->get_current_time(), event);
+		dftl_stats.num_demand_misses++;
+	}
+}
+
+// Issues mapping reads for the PREFETCH_DEPTH translation pages following the one a sequential read stream is on,
+// so that they are in the prefetch buffer by the time the stream reaches them.
+// The buffer is kept separate from the cached mapping table so that prefetching does not evict demand entries.
+void DFTL::prefetch_translation_pages(long translation_page_id, double time) {
+	long num_translation_pages = ceil(NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR / ENTRIES_PER_TRANSLATION_PAGE);
+	for (long id = translation_page_id + 1; id <= translation_page_id + PREFETCH_DEPTH && id < num_translation_pages; id++) {
+		long mapping_address = NUMBER_OF_ADDRESSABLE_PAGES() - id;
+		if (ongoing_mapping_operations.count(mapping_address) == 1 || find(prefetch_buffer.begin(), prefetch_buffer.end(), id) != prefetch_buffer.end()) {
+			continue;
+		}
+		if (page_mapping->get_physical_address(mapping_address).valid == NONE) {
+			continue;
+		}
+		create_mapping_read(id, time, NULL);
+		prefetches_in_flight.insert(id);
+		unused_prefetches.insert(id);
+		dftl_stats.num_prefetches++;
 	}
 }
 
+void DFTL::register_prefetch_hit(long translation_page_id) {
+	dftl_stats.num_prefetch_hits++;
+	if (unused_prefetches.erase(translation_page_id) == 1) {
+		dftl_stats.num_useful_prefetches++;
+	}
+}
+
+// Returns whether the translation page is in the Host Memory Buffer. If so, the event is delayed by the PCIe round-trip.
+bool DFTL::lookup_host_memory_buffer(long translation_page_id, Event* event) {
+	if (HMB_TRANSLATION_PAGES == 0) {
+		return false;
+	}
+	auto it = host_memory_buffer_index.find(translation_page_id);
+	if (it == host_memory_buffer_index.end()) {
+		dftl_stats.num_hmb_misses++;
+		return false;
+	}
+	host_memory_buffer.splice(host_memory_buffer.begin(), host_memory_buffer, it->second);
+	dftl_stats.num_hmb_hits++;
+	event->incr_accumulated_wait_time(HMB_LATENCY);
+	event->incr_pure_ssd_wait_time(HMB_LATENCY);
+	return true;
+}
+
+// Called whenever the controller holds an up to date copy of a translation page. The least recently used page is evicted.
+void DFTL::insert_into_host_memory_buffer(long translation_page_id) {
+	if (HMB_TRANSLATION_PAGES == 0) {
+		return;
+	}
+	auto it = host_memory_buffer_index.find(translation_page_id);
+	if (it != host_memory_buffer_index.end()) {
+		host_memory_buffer.splice(host_memory_buffer.begin(), host_memory_buffer, it->second);
+		return;
+	}
+	if (host_memory_buffer.size() >= HMB_TRANSLATION_PAGES) {
+		host_memory_buffer_index.erase(host_memory_buffer.back());
+		host_memory_buffer.pop_back();
+	}
+	host_memory_buffer.push_front(translation_page_id);
+	host_memory_buffer_index[translation_page_id] = host_memory_buffer.begin();
+}
+
 void DFTL::register_read_completion(Event const& event, enum status result) {
 	page_mapping->register_read_completion(event, result);
 
@@ -77,6 +185,7 @@ void DFTL::register_read_completion(Event const& event, enum status result) {
 	long translation_page_id = - (event.get_logical_address() - NUMBER_OF_ADDRESSABLE_PAGES());
 
 	notify_garbage_collector(translation_page_id, event.get_current_time());
+	insert_into_host_memory_buffer(translation_page_id);
 	// Insert all entries into cached mapping table with hotness 0
 	/*for (int i = translation_page_id * ENTRIES_PER_TRANSLATION_PAGE; i < (translation_page_id + 1) * ENTRIES_PER_TRANSLATION_PAGE; i++) {
 		if (cache.cached_mapping_table.count(i) == 0) {
@@ -100,6 +209,15 @@ void DFTL::register_read_completion(Event const& event, enum status result) {
 		scheduler->schedule_event(e);
 	}
 
+	// The buffer holds the translation pages of the current and upcoming prefetch windows
+	if (prefetches_in_flight.erase(translation_page_id) == 1) {
+		prefetch_buffer.push_back(translation_page_id);
+		if (prefetch_buffer.size() > 2 * PREFETCH_DEPTH) {
+			unused_prefetches.erase(prefetch_buffer.front());
+			prefetch_buffer.pop_front();
+		}
+	}
+
 	try_clear_space_in_mapping_cache(event.get_current_time());
 }
 
@@ -151,11 +269,12 @@ void DFTL::register_write_completion(Event const& event, enum status result) {
 		int i = 0;
 		i++;
 	}
-	if (event.is_original_application_io() && gc != NULL && cache->contains(event.get_logical_address())) {
+	// A noop write was superseded by a later write to the same address, and changes nothing
+	if (event.is_original_application_io() && !event.get_noop() && gc != NULL && cache->contains(event.get_logical_address())) {
 		Address pa = page_mapping->get_physical_address(event.get_logical_address());
 		gc->invalid_address_notification(pa, event.get_current_time());
 	}
-	if (event.is_original_application_io()) {
+	if (event.is_original_application_io() && !event.get_noop()) {
 		cache->register_write_arrival(event);	// caution. Moved this here from the write method. may lead to other problems.
 	}
 	if (event.is_garbage_collection_op()) {
@@ -177,9 +296,20 @@ void DFTL::register_write_completion(Event const& event, enum status result) {
 	ongoing_mapping_operations.erase(event.get_logical_address());
 	long translation_page_id = - (event.get_logical_address() - NUMBER_OF_ADDRESSABLE_PAGES());
 
+	// The translation page may have been written without being read first. The old addresses it held must reach the
+	// garbage-collector before they are overwritten.
+	notify_garbage_collector(translation_page_id, event.get_current_time());
+
 	// mark all pages included as clean
 	mark_clean(translation_page_id, event);
 
+	// a prefetched copy of the translation page is now out of date
+	deque<long>::iterator prefetched = find(prefetch_buffer.begin(), prefetch_buffer.end(), translation_page_id);
+	if (prefetched != prefetch_buffer.end()) {
+		unused_prefetches.erase(translation_page_id);
+		prefetch_buffer.erase(prefetched);
+	}
+
 	mapping_pages[translation_page_id].entries.clear();
 	long first_key_in_translation_page = translation_page_id * ENTRIES_PER_TRANSLATION_PAGE;
 	for (int i = first_key_in_translation_page;
@@ -187,6 +317,7 @@ void DFTL::register_write_completion(Event const& event, enum status result) {
 		Address a = page_mapping->get_physical_address(i);
 		mapping_pages[translation_page_id].entries[i] = a;
 	}
+	insert_into_host_memory_buffer(translation_page_id);
 
 
 	// schedule all operations
@@ -279,7 +410,7 @@ void DFTL::mark_clean(long translation_page_id, Event const& event) {
 
 	StatisticData::register_statistic("dftl_cache_size", {
 			new Integer(StatisticsGatherer::get_global_instance()->total_writes()),
-			new Integer(cache->cached_mapping_table.size()),
+			new Integer(cache->get_num_slots()),
 			new Integer(ftl_cache::CACHED_ENTRIES_THRESHOLD)
 	});
 
@@ -300,7 +431,7 @@ void DFTL::mark_clean(long translation_page_id, Event const& event) {
 void DFTL::try_clear_space_in_mapping_cache(double time) {
 	//while (cache.cached_mapping_table.size() >= CACHED_ENTRIES_THRESHOLD && flush_mapping(time, false));
 	cache->clear_clean_entries(time);
-	if (cache->cached_mapping_table.size() <= ftl_cache::CACHED_ENTRIES_THRESHOLD) {
+	if (cache->get_num_slots() <= ftl_cache::CACHED_ENTRIES_THRESHOLD) {
 		return;
 	}
 	//flush_mapping(time, true);
@@ -348,7 +479,8 @@ void DFTL::try_clear_space_in_mapping_cache(double time) {
 			}
 		}*/
 
-		if (are_all_mapping_entries_cached) {
+		// The translation page can be merged with the dirty entries from the Host Memory Buffer copy instead of being read from flash
+		if (are_all_mapping_entries_cached || lookup_host_memory_buffer(translation_page_id, mapping_event)) {
 			application_ios_waiting_for_translation[translation_page_id] = vector<Event*>();
 			ongoing_mapping_operations.insert(mapping_event->get_logical_address());
 			//printf("submitting mapping write, all in RAM %d\n", translation_page_id);
@@ -370,7 +502,9 @@ void DFTL::create_mapping_read(long translation_page_id, double time, Event* dep
 	Address physical_addr_of_translation_page = page_mapping->get_physical_address(mapping_event->get_logical_address());
 	mapping_event->set_address(physical_addr_of_translation_page);
 	application_ios_waiting_for_translation[translation_page_id] = vector<Event*>();
-	application_ios_waiting_for_translation[translation_page_id].push_back(dependant);
+	if (dependant != NULL) {
+		application_ios_waiting_for_translation[translation_page_id].push_back(dependant);
+	}
 	assert(ongoing_mapping_operations.count(mapping_event->get_logical_address()) == 0);
 	ongoing_mapping_operations.insert(mapping_event->get_logical_address());
 	scheduler->schedule_event(mapping_event);
@@ -393,7 +527,7 @@ void DFTL::print_short() const {
 	}
 	printf("total: %d\tdirty: %d\tclean: %d\tfixed: %d\tcold: %d\thot: %d\tvery hot: %d\tnum ios: %d\n", cache->cached_mapping_table.size(), num_dirty, num_clean, num_fixed, num_cold, num_hot, num_super_hot, StatisticsGatherer::get_global_instance()->total_writes());
 	printf("clean queue: %d \t dirty queue %d \n", cache->eviction_queue_clean.size(), cache->eviction_queue_dirty.size());
-	printf("threshold: %d\t cache: %d\n", ftl_cache::CACHED_ENTRIES_THRESHOLD, cache->cached_mapping_table.size());
+	printf("threshold: %d\t cache: %d\t slots: %d\n", ftl_cache::CACHED_ENTRIES_THRESHOLD, cache->cached_mapping_table.size(), cache->get_num_slots());
 }
 
 // used for debugging
@@ -442,6 +576,22 @@ void DFTL::print() const {
 	}
 	//printf("total pages %d\n", total);
 
+	cache->print_stats();
+
+	if (dftl_stats.num_prefetches > 0) {
+		long num_covered_misses = dftl_stats.num_prefetch_hits + dftl_stats.num_demand_misses;
+		printf("prefetch mapping reads\t%ld\n", dftl_stats.num_prefetches);
+		printf("prefetch accuracy\t%f\n", dftl_stats.num_useful_prefetches / (double)dftl_stats.num_prefetches);
+		printf("prefetch coverage\t%f\n", num_covered_misses == 0 ? 0 : dftl_stats.num_prefetch_hits / (double)num_covered_misses);
+	}
+
+	if (HMB_TRANSLATION_PAGES > 0) {
+		long num_hmb_lookups = dftl_stats.num_hmb_hits + dftl_stats.num_hmb_misses;
+		printf("hmb hits\t%ld\n", dftl_stats.num_hmb_hits);
+		printf("hmb misses\t%ld\n", dftl_stats.num_hmb_misses);
+		printf("hmb hit rate\t%f\n", num_hmb_lookups == 0 ? 0 : dftl_stats.num_hmb_hits / (double)num_hmb_lookups);
+	}
+
 
 	/*printf("address histogram:");
 	for (auto i : dftl_stats.address_hits) {
@@ -15,9 +15,15 @@ FAST::FAST(Ssd *ssd, Block_manager_parent* bm, Migrator* migrator) :
 		migrator(migrator),
 		page_mapping(FtlImpl_Page(ssd, bm)),
 		full_log_blocks(),
-		queued_events(),
-		gc_queue(),
-		logical_dependencies()
+		queued_events(NUMBER_OF_ADDRESSABLE_BLOCKS()),
+		locked_blocks(NUMBER_OF_ADDRESSABLE_BLOCKS(), false),
+		events_without_space(),
+		gc_queue(NUMBER_OF_ADDRESSABLE_BLOCKS()),
+		being_merged(NUMBER_OF_ADDRESSABLE_BLOCKS(), false),
+		num_blocks_being_merged(0),
+		num_switch_merges(0),
+		num_partial_merges(0),
+		num_full_merges(0)
 {
 	// The over-provisioned blocks serve as log blocks. We don't use all of them, though, because we need to keep
 	// reserve free blocks for garbage-collection
@@ -39,9 +45,15 @@ FAST::FAST() :
 		migrator(),
 		page_mapping(),
 		full_log_blocks(),
-		queued_events(),
-		gc_queue(),
-		logical_dependencies()
+		queued_events(NUMBER_OF_ADDRESSABLE_BLOCKS()),
+		locked_blocks(NUMBER_OF_ADDRESSABLE_BLOCKS(), false),
+		events_without_space(),
+		gc_queue(NUMBER_OF_ADDRESSABLE_BLOCKS()),
+		being_merged(NUMBER_OF_ADDRESSABLE_BLOCKS(), false),
+		num_blocks_being_merged(0),
+		num_switch_merges(0),
+		num_partial_merges(0),
+		num_full_merges(0)
 {
 	IS_FTL_PAGE_MAPPING = false;
 }
@@ -49,8 +61,8 @@ FAST::FAST() :
 FAST::~FAST(void)
 {
 	print();
-	assert(queued_events.empty());
-	assert(gc_queue.empty());
+	assert(events_without_space.empty());
+	assert(num_blocks_being_merged == 0);
 }
 
 void FAST::read(Event *event)
@@ -62,15 +74,15 @@ void FAST::register_read_completion(Event const& event, enum status result) {
 	int block_id = event.get_logical_address() / BLOCK_SIZE;
 
 	if (event.is_garbage_collection_op()) {
-		queue<Event*>& q = gc_queue.at(block_id);
+		list<Event*>& q = gc_queue[block_id];
 		Event* gc_write = q.front();
-		q.pop();
+		q.pop_front();
 		gc_write->set_start_time(event.get_current_time());
 		write(gc_write);
 		if (q.size() > 0) {
 			Event* gc_read = q.front();
 			set_read_address(*gc_read);
-			q.pop();
+			q.pop_front();
 			gc_read->set_start_time(event.get_current_time());
 			scheduler->schedule_event(gc_read);
 		}
@@ -79,20 +91,20 @@ void FAST::register_read_completion(Event const& event, enum status result) {
 }
 
 void FAST::schedule(Event* e) {
-	int phys_block_id = e->get_address().get_block_id();
-	if (queued_events.count(phys_block_id) == 0) {
+	long phys_block_id = e->get_address().get_block_id();
+	if (!locked_blocks[phys_block_id]) {
 		scheduler->schedule_event(e);
 	}
 	queue_up(e, e->get_address());
 }
 
 void FAST::queue_up(Event* e, Address const& lock) {
-	int phys_block_id = lock.get_block_id();
-	if (queued_events.count(phys_block_id) == 0) {
-		queued_events[phys_block_id] = queue<Event*>();
+	long phys_block_id = lock.get_block_id();
+	if (!locked_blocks[phys_block_id]) {
+		locked_blocks[phys_block_id] = true;
 	}
 	else {
-		queued_events.at(phys_block_id).push(e);
+		queued_events[phys_block_id].push_back(e);
 	}
 }
 
@@ -116,7 +128,7 @@ void FAST::write(Event *event)
 		schedule(event);
 	}
 	// The block is being garbage-collected.
-	else if (gc_queue.count(block_id) == 1 && !event->is_garbage_collection_op()) {
+	else if (being_merged[block_id] && !event->is_garbage_collection_op()) {
 		write_in_log_block(event);
 	}
 	// can write next page
@@ -143,11 +155,15 @@ void FAST::write_in_log_block(Event* event) {
 	if (active_log_blocks_map.count(block_id) == 1 && active_log_blocks_map.at(block_id)->addr.page < BLOCK_SIZE) {
 		log_block* log_block_id = active_log_blocks_map.at(block_id);
 		Address& log_block_addr = log_block_id->addr;
-		if (log_block_addr.get_block_id() == 1544) {
-			int i = 0;
-			i++;
+		int page_id = event->get_logical_address() % BLOCK_SIZE;
+		// A sequential log block is about to become random. Try to turn it into a data block with a partial merge first.
+		if (log_block_id->sequential && page_id != log_block_addr.page) {
+			if (partial_merge(block_id, log_block_id, event->get_current_time())) {
+				events_without_space.push(event);
+				return;
+			}
+			log_block_id->sequential = false;
 		}
-		int block_id_log = log_block_addr.get_block_id();
 		event->set_address(log_block_addr);
 		log_block_addr.page++;
 		schedule(event);
@@ -156,10 +172,7 @@ void FAST::write_in_log_block(Event* event) {
 	else if (active_log_blocks_map.count(block_id) == 1 /*&& active_log_blocks_map.at(block_id)->addr.page == BLOCK_SIZE */) {
 		log_block* log_block_id = active_log_blocks_map.at(block_id);
 		Address& log_block_addr = log_block_id->addr;
-		int block_id_log = log_block_addr.get_block_id();
-		//printf("block_id_log  %d\n");
-		assert(queued_events.count(log_block_addr.get_block_id()) == 1);
-		int size = queued_events.at(log_block_addr.get_block_id()).size();
+		assert(locked_blocks[log_block_addr.get_block_id()]);
 		queue_up(event, log_block_addr);
 		//queued_events[log_block_addr.get_block_id()].push(event);
 	}
@@ -175,6 +188,7 @@ void FAST::write_in_log_block(Event* event) {
 			new_addr.page++;
 			log_block* lb = new log_block(new_addr);
 			lb->num_blocks_mapped_inside.insert(block_id);
+			lb->sequential = event->get_logical_address() % BLOCK_SIZE == 0;
 			active_log_blocks_map[block_id] = lb;
 			num_active_log_blocks++;
 			schedule(event);
@@ -198,6 +212,7 @@ void FAST::choose_existing_log_block(Event* event) {
 			event->set_address(lb->addr);
 			lb->addr.page++;
 			lb->num_blocks_mapped_inside.insert(block_id);
+			lb->sequential = false;
 			active_log_blocks_map[block_id] = lb;
 			dial = (*it).first + 1;
 			schedule(event);
@@ -212,49 +227,37 @@ void FAST::choose_existing_log_block(Event* event) {
 			event->set_address(lb->addr);
 			lb->addr.page++;
 			lb->num_blocks_mapped_inside.insert(block_id);
+			lb->sequential = false;
 			active_log_blocks_map[block_id] = lb;
 			dial = (*it).first + 1;
-			if (event->get_id() == 32017) {
-				int i = 0;
-				i++;
-			}
 			schedule(event);
 			return;
 		}
 	}
 	assert(!event->is_garbage_collection_op());
-	queued_events[-1].push(event);
+	events_without_space.push(event);
 }
 
 void FAST::release_events_there_was_no_space_for() {
-	if (queued_events.count(-1) == 0) {
-		return;
-	}
-	queue<Event*>& q = queued_events.at(-1);
+	queue<Event*>& q = events_without_space;
 	int initial_size = q.size();
 	for (int i = 0; i < initial_size; i++) {
 		Event* e = q.front();
-		if (e->get_application_io_id() == 77645) {
-			int i =0;
-			i++;
-		}
 		q.pop();
 		write(e);
 	}
-	if (q.empty()) {
-		queued_events.erase(-1);
-	}
 }
 
 void FAST::unlock_block(Event const& event) {
-	queue<Event*>& dependants = queued_events.at(event.get_address().get_block_id());
+	long phys_block_id = event.get_address().get_block_id();
+	list<Event*>& dependants = queued_events[phys_block_id];
 	if (dependants.empty()) {
-		queued_events.erase(event.get_address().get_block_id());
+		locked_blocks[phys_block_id] = false;
 	}
 	else if (event.get_address().page == BLOCK_SIZE - 1) {
 		while (!dependants.empty()) {
 			Event* e = dependants.front();
-			dependants.pop();
+			dependants.pop_front();
 			if (e->get_event_type() == WRITE && e->get_address().valid == NONE) {
 				write(e);
 			}
@@ -263,11 +266,11 @@ void FAST::unlock_block(Event const& event) {
 				scheduler->schedule_event(e);
 			}
 		}
-		queued_events.erase(event.get_address().get_block_id());
+		locked_blocks[phys_block_id] = false;
 	}
 	else {
 		Event* e = dependants.front();
-		dependants.pop();
+		dependants.pop_front();
 		if (e->get_event_type() == WRITE && e->get_address().valid == NONE) {
 			write(e);
 		}
@@ -279,7 +282,7 @@ void FAST::unlock_block(Event const& event) {
 }
 
 void FAST::register_erase_completion(Event & event) {
-	if (gc_queue.empty()) {
+	if (num_blocks_being_merged == 0) {
 		release_events_there_was_no_space_for();
 		consider_doing_garbage_collection(event.get_current_time());
 	}
@@ -293,12 +296,11 @@ void FAST::register_write_completion(Event const& event, enum status result) {
 	assert(normal_block.valid == PAGE);
 
 	if (event.is_garbage_collection_op()) {
-		queue<Event*>& q = gc_queue[block_id];
-		if (q.empty() && event.get_address().page == BLOCK_SIZE - 1) {
-			gc_queue.erase(block_id);
+		if (gc_queue[block_id].empty() && event.get_address().page == BLOCK_SIZE - 1) {
+			being_merged[block_id] = false;
+			num_blocks_being_merged--;
 		}
-		int size = gc_queue.size();
-		if (gc_queue.empty()) {
+		if (num_blocks_being_merged == 0) {
 			num_active_log_blocks--;
 			release_events_there_was_no_space_for();
 			consider_doing_garbage_collection(event.get_current_time());
@@ -335,26 +337,18 @@ void FAST::register_write_completion(Event const& event, enum status result) {
 		}
 	}
 
-	// Log block is out of space. First check if a switch operation is possible.
-	if (lb->num_blocks_mapped_inside.size() == 1) {
-		// check if they are in order
-		bool in_order = true;
-		int first_logical_address = event.get_logical_address() / BLOCK_SIZE * BLOCK_SIZE;
-		for (int i = 0; i < BLOCK_SIZE; i++) {
-			Address logical_page_i = page_mapping.get_physical_address(first_logical_address + i);
-			if (!(logical_page_i.compare(log_block_addr) >= BLOCK && logical_page_i.page == i)) {
-				in_order = false;
-			}
-		}
-
-		if (in_order) {
-			translation_table[block_id] = log_block_addr;
-			num_active_log_blocks--;
-			delete lb;
-		}
-		else {
-			full_log_blocks.push(lb);
+	// Log block is out of space. If it holds the whole logical block in order, a switch merge is possible:
+	// the log block simply becomes the new data block and nothing has to be copied.
+	if (lb->sequential && lb->num_blocks_mapped_inside.size() == 1 && !being_merged[block_id]) {
+		// The old data block can be erased as soon as the page this write replaces in it is invalidated
+		Address const& replaced = event.get_replace_address();
+		if (replaced.valid != NONE && replaced.compare(normal_block) >= BLOCK) {
+			migrator->update_structures(normal_block, event.get_current_time());
 		}
+		translation_table[block_id] = log_block_addr;
+		num_active_log_blocks--;
+		num_switch_merges++;
+		delete lb;
 	}
 	else {
 		full_log_blocks.push(lb);
@@ -366,7 +360,7 @@ void FAST::register_write_completion(Event const& event, enum status result) {
 
 
 void FAST::consider_doing_garbage_collection(double time) {
-	if (full_log_blocks.size() < 1 || gc_queue.size() > 0) {
+	if (full_log_blocks.size() < 1 || num_blocks_being_merged > 0) {
 		return;
 	}
 
@@ -401,6 +395,7 @@ void FAST::consider_doing_garbage_collection(double time) {
 
 	for (auto b : logical_blocks_to_garbage_collect) {
 		garbage_collect(b, lb, time);
+		num_full_merges++;
 	}
 
 	delete lb;
@@ -409,38 +404,68 @@ void FAST::consider_doing_garbage_collection(double time) {
 // TODO: an optimization is possible here. When rewriting a block, the reads are on different blocks. Issue them in parallel
 void FAST::garbage_collect(int block_id, log_block* log_block, double time) {
 	Address new_addr = bm->find_free_unused_block(time);
-	assert(queued_events.count(new_addr.get_block_id()) == 0);
 	if (new_addr.valid < BLOCK) {
 		printf("We ran out of free available log blocks. We are now stuck because we cannot complete gabrage collection.");
 		printf("Try to increase over-provisioning.");
 	}
 	assert(new_addr.valid >= BLOCK);
+	assert(!locked_blocks[new_addr.get_block_id()]);
+
+	Address& old_addr = translation_table[block_id];
+	migrator->update_structures(old_addr, time);
+	bm->subtract_from_available_for_new_writes(BLOCK_SIZE);
+	translation_table[block_id] = new_addr;
+	issue_merge_migrations(block_id, 0, time);
+}
+
+// A sequential log block holding the first pages of a logical block, in order, while the rest of the logical block
+// is still in its data block, only needs the remaining pages copied behind the written ones.
+// It then becomes the new data block. Returns false if the preconditions do not hold.
+bool FAST::partial_merge(int block_id, log_block* lb, double time) {
+	Address& old_addr = translation_table[block_id];
+	Address log_block_addr = lb->addr;
+	int num_pages_to_copy = BLOCK_SIZE - log_block_addr.page;
+	if (num_blocks_being_merged > 0 || lb->num_blocks_mapped_inside.size() != 1 || old_addr.page != BLOCK_SIZE
+			|| locked_blocks[log_block_addr.get_block_id()] || locked_blocks[old_addr.get_block_id()]) {
+		return false;
+	}
+	Block const* data_block = ssd->get_package(old_addr.package)->get_die(old_addr.die)->get_plane(old_addr.plane)->get_block(old_addr.block);
+	if (data_block->get_pages_valid() != num_pages_to_copy) {
+		return false;
+	}
 
-	//translation_table[block_id].print();
-	//new_addr.print();
-	//printf("\t%d\n", block_id);
+	active_log_blocks_map.erase(block_id);
+	migrator->update_structures(old_addr, time);
+	bm->subtract_from_available_for_new_writes(num_pages_to_copy);
+	translation_table[block_id] = log_block_addr;
+	issue_merge_migrations(block_id, log_block_addr.page, time);
+	num_partial_merges++;
+	delete lb;
+	return true;
+}
+
+// Queues a read and a write for every page of the logical block from first_page onwards, and starts the first read.
+// The writes go wherever translation_table points, which the caller has set up.
+void FAST::issue_merge_migrations(int block_id, int first_page, double time) {
+	list<Event*>& q = gc_queue[block_id];
 	long first_logical_addr = block_id * BLOCK_SIZE;
-	gc_queue[block_id] = queue<Event*>();
-	for (int i = 0; i < BLOCK_SIZE; i++) {
+	for (int i = first_page; i < BLOCK_SIZE; i++) {
 		long la = first_logical_addr + i;
 
 		Event* read = new Event(READ, la, 1, time);
 		read->set_garbage_collection_op(true);
 		Event* write = new Event(WRITE, la, 1, time);
 		write->set_garbage_collection_op(true);
-		//write->set_address(new_addr);
 
-		gc_queue[block_id].push(read);
-		gc_queue[block_id].push(write);
+		q.push_back(read);
+		q.push_back(write);
 	}
+	being_merged[block_id] = true;
+	num_blocks_being_merged++;
 
-	Address& old_addr = translation_table[block_id];
-	migrator->update_structures(old_addr, time);
-	bm->subtract_from_available_for_new_writes(BLOCK_SIZE);
-	translation_table[block_id] = new_addr;
-	Event* first_read = gc_queue[block_id].front();
+	Event* first_read = q.front();
 	set_read_address(*first_read);
-	gc_queue[block_id].pop();
+	q.pop_front();
 	scheduler->schedule_event(first_read);
 }
 
@@ -475,15 +500,15 @@ void FAST::set_read_address(Event& event) const {
 	event.set_address(cur_block_addr);
 }
 
-// used for debugging
 void FAST::print() const {
-	for (auto locked_block : queued_events) {
-		printf("block: %d\n", locked_block.first);
-		queue<Event*>& q = locked_block.second;
-		for (int i = 0; i < q.size(); i++) {
-			Event* e = q.front();
-			q.pop();
-			printf("block: %d    logical address: %d\t", locked_block.first, e->get_logical_address());
+	printf("switch merges\t%ld\n", num_switch_merges);
+	printf("partial merges\t%ld\n", num_partial_merges);
+	printf("full merges\t%ld\n", num_full_merges);
+
+	// used for debugging
+	for (uint i = 0; i < queued_events.size(); i++) {
+		for (auto e : queued_events[i]) {
+			printf("block: %d    logical address: %d\t", i, e->get_logical_address());
 			e->print();
 		}
 	}
@@ -0,0 +1,278 @@
+#include <new>
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+#include "../ssd.h"
+
+using namespace ssd;
+
+int ZNS::BLOCKS_PER_ZONE = 1;
+
+ZNS::ZNS(Ssd *ssd, Block_manager_parent* bm, Migrator* migrator) :
+		FtlParent(ssd, bm),
+		zones(ceil(NUMBER_OF_ADDRESSABLE_PAGES() / (double)get_zone_size())),
+		zone_of_block(NUMBER_OF_ADDRESSABLE_BLOCKS(), UNDEFINED),
+		blocks_waiting_for_space(),
+		migrator(migrator),
+		num_zone_resets(0),
+		num_zone_appends(0),
+		num_rejected_writes(0),
+		num_unwritten_reads(0)
+{
+	// The host decides when space is reclaimed, so the device must never start garbage-collection or move data on its own
+	if (GREED_SCALE > 0) {
+		printf("Warning: the parameter GREED_SCALE must be set to 0 for ZNS. We set it to 0 here on your behalf.\n");
+	}
+	GREED_SCALE = 0;
+	if (ENABLE_WEAR_LEVELING) {
+		printf("Warning: wear-leveling is not supported for ZNS. We disable it here on your behalf.\n");
+	}
+	ENABLE_WEAR_LEVELING = false;
+	// zones must be written in order, which the destaging of a write cache does not respect
+	if (WRITE_CACHE_PAGES > 0) {
+		printf("Warning: the write cache is not supported for ZNS. We disable it here on your behalf.\n");
+	}
+	WRITE_CACHE_PAGES = 0;
+	// a trim resets the whole zone, so the read cache would have to drop every page of the zone
+	if (READ_CACHE_PAGES > 0) {
+		printf("Warning: the read cache is not supported for ZNS. We disable it here on your behalf.\n");
+	}
+	READ_CACHE_PAGES = 0;
+	IS_FTL_PAGE_MAPPING = false;
+}
+
+ZNS::~ZNS(void)
+{
+	print();
+	assert(blocks_waiting_for_space.empty());
+}
+
+void ZNS::read(Event *event)
+{
+	// reading beyond the write pointer returns no data, so there is nothing to read from flash
+	if (get_physical_address(event->get_logical_address()).valid == NONE) {
+		num_unwritten_reads++;
+		event->set_noop(true);
+	}
+	scheduler->schedule_event(event);
+}
+
+void ZNS::write(Event *event)
+{
+	long zone_id = event->get_logical_address() / get_zone_size();
+	zone& z = zones[zone_id];
+	if (event->is_zone_append() && z.state != ZONE_FULL && z.reset == NULL) {
+		event->set_logical_address(zone_id * get_zone_size() + z.write_pointer);
+		num_zone_appends++;
+	}
+	long offset = event->get_logical_address() % get_zone_size();
+	if (z.state == ZONE_FULL || z.reset != NULL || offset != z.write_pointer) {
+		reject(event);
+		return;
+	}
+
+	if (z.state == ZONE_EMPTY) {
+		z.state = ZONE_OPEN;
+		z.blocks.resize(BLOCKS_PER_ZONE);
+	}
+	if (++z.write_pointer == get_zone_size()) {
+		z.state = ZONE_FULL;
+	}
+
+	int index = offset % BLOCKS_PER_ZONE;
+	zone_block& b = z.blocks[index];
+	b.pending.push(event);
+	if (b.addr.valid == NONE && !allocate_block(zone_id, index, event->get_current_time())) {
+		blocks_waiting_for_space.insert(pair<int, int>(zone_id, index));
+	}
+	else if (!b.busy) {
+		dispatch(zone_id, index);
+	}
+}
+
+// A trim on any address of a zone resets the whole zone
+void ZNS::trim(Event *event)
+{
+	long zone_id = event->get_logical_address() / get_zone_size();
+	zone& z = zones[zone_id];
+	if (z.state == ZONE_EMPTY || z.reset != NULL) {
+		event->set_noop(true);
+		scheduler->schedule_event(event);
+		return;
+	}
+	z.reset = event;
+	if (is_idle(z)) {
+		reset_zone(zone_id, event->get_current_time());
+	}
+}
+
+void ZNS::reject(Event* event) {
+	num_rejected_writes++;
+	event->set_noop(true);
+	scheduler->schedule_event(event);
+}
+
+// Zones are spread over the LUNs, and so are the blocks of a zone
+bool ZNS::allocate_block(int zone_id, int index, double time) {
+	int lun = (zone_id * BLOCKS_PER_ZONE + index) % (SSD_SIZE * PACKAGE_SIZE);
+	Address addr = bm->find_free_unused_block(lun / PACKAGE_SIZE, lun % PACKAGE_SIZE, time);
+	if (addr.valid == NONE) {
+		addr = bm->find_free_unused_block(time);
+	}
+	if (addr.valid == NONE) {
+		return false;
+	}
+	assert(addr.page == 0);
+	addr.valid = PAGE;
+	zones[zone_id].blocks[index].addr = addr;
+	zone_of_block[addr.get_block_id()] = zone_id * BLOCKS_PER_ZONE + index;
+	return true;
+}
+
+// Pages in a block must be written in order, so only one write per block is in flight at a time
+void ZNS::dispatch(int zone_id, int index) {
+	zone_block& b = zones[zone_id].blocks[index];
+	Event* event = b.pending.front();
+	b.pending.pop();
+	assert(b.addr.page == event->get_logical_address() % get_zone_size() / BLOCKS_PER_ZONE);
+	event->set_address(b.addr);
+	b.addr.page++;
+	b.busy = true;
+	scheduler->schedule_event(event);
+}
+
+bool ZNS::is_idle(zone const& z) const {
+	for (auto& b : z.blocks) {
+		if (b.busy || !b.pending.empty()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// The blocks of the zone are erased in the background. The zone can be written again right away.
+void ZNS::reset_zone(int zone_id, double time) {
+	zone& z = zones[zone_id];
+	for (auto& b : z.blocks) {
+		if (b.addr.valid == NONE) {
+			continue;
+		}
+		Address block_addr = b.addr;
+		block_addr.valid = BLOCK;
+		block_addr.page = 0;
+		zone_of_block[block_addr.get_block_id()] = UNDEFINED;
+		migrator->erase_discarded_block(block_addr, time);
+	}
+	z.blocks.clear();
+	z.state = ZONE_EMPTY;
+	z.write_pointer = 0;
+	num_zone_resets++;
+
+	Event* reset = z.reset;
+	z.reset = NULL;
+	double diff = time - reset->get_current_time();
+	if (diff > 0) {
+		reset->incr_accumulated_wait_time(diff);
+		reset->incr_pure_ssd_wait_time(diff);
+	}
+	reset->set_noop(true);
+	scheduler->schedule_event(reset);
+}
+
+void ZNS::register_write_completion(Event const& event, enum status result) {
+	collect_stats(event);
+	if (event.get_address().valid == NONE) {
+		return;
+	}
+	long zone_id = event.get_logical_address() / get_zone_size();
+	int index = event.get_logical_address() % get_zone_size() % BLOCKS_PER_ZONE;
+	zone& z = zones[zone_id];
+	zone_block& b = z.blocks[index];
+	b.busy = false;
+	if (!b.pending.empty()) {
+		dispatch(zone_id, index);
+	}
+	else if (z.reset != NULL && is_idle(z)) {
+		reset_zone(zone_id, event.get_current_time());
+	}
+}
+
+void ZNS::register_read_completion(Event const& event, enum status result) {
+	collect_stats(event);
+}
+
+// resets are carried out when the trim arrives
+void ZNS::register_trim_completion(Event & event) {}
+
+// An erase frees a block, so writes waiting for space may proceed
+void ZNS::register_erase_completion(Event & event) {
+	set<pair<int, int> > waiting;
+	waiting.swap(blocks_waiting_for_space);
+	for (auto w : waiting) {
+		zone_block& b = zones[w.first].blocks[w.second];
+		if (b.addr.valid != NONE) {
+			continue;
+		}
+		if (!allocate_block(w.first, w.second, event.get_current_time())) {
+			blocks_waiting_for_space.insert(w);
+		}
+		else if (!b.busy && !b.pending.empty()) {
+			dispatch(w.first, w.second);
+		}
+	}
+}
+
+long ZNS::get_logical_address(uint physical_address) const {
+	long zone_and_index = zone_of_block[physical_address / BLOCK_SIZE];
+	if (zone_and_index == UNDEFINED) {
+		return UNDEFINED;
+	}
+	long zone_id = zone_and_index / BLOCKS_PER_ZONE;
+	int index = zone_and_index % BLOCKS_PER_ZONE;
+	return zone_id * get_zone_size() + (physical_address % BLOCK_SIZE) * BLOCKS_PER_ZONE + index;
+}
+
+Address ZNS::get_physical_address(uint logical_address) const {
+	zone const& z = zones[logical_address / get_zone_size()];
+	long offset = logical_address % get_zone_size();
+	if (offset >= z.write_pointer) {
+		return Address();
+	}
+	zone_block const& b = z.blocks[offset % BLOCKS_PER_ZONE];
+	uint page = offset / BLOCKS_PER_ZONE;
+	if (b.addr.valid == NONE || page >= b.addr.page) {
+		return Address();
+	}
+	Address addr = b.addr;
+	addr.page = page;
+	return addr;
+}
+
+// pages are never overwritten in place
+void ZNS::set_replace_address(Event& event) const {
+	event.set_replace_address(Address());
+}
+
+void ZNS::set_read_address(Event& event) const {
+	Address addr = get_physical_address(event.get_logical_address());
+	if (addr.valid == NONE) {
+		event.set_noop(true);
+	}
+	else {
+		event.set_address(addr);
+	}
+}
+
+void ZNS::print() const {
+	int num_open_zones = 0;
+	for (auto& z : zones) {
+		if (z.state == ZONE_OPEN) {
+			num_open_zones++;
+		}
+	}
+	printf("zone resets\t%ld\n", num_zone_resets);
+	printf("zone appends\t%ld\n", num_zone_appends);
+	printf("rejected writes\t%ld\n", num_rejected_writes);
+	printf("reads of unwritten pages\t%ld\n", num_unwritten_reads);
+	printf("open zones\t%d\n", num_open_zones);
+}
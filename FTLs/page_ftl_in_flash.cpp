@@ -15,6 +15,17 @@
 using namespace ssd;
 
 int ftl_cache::CACHED_ENTRIES_THRESHOLD = 10000;
+bool ftl_cache::RANGE_COMPRESSION = false;
+
+ftl_cache::ftl_cache(FtlImpl_Page* page_mapping) :
+		cached_mapping_table(),
+		eviction_queue_dirty(),
+		eviction_queue_clean(),
+		page_mapping(page_mapping),
+		num_ranges(0),
+		num_hits(0),
+		num_misses(0)
+{}
 
 void ftl_cache::register_write_arrival(Event const& event)
 {
@@ -29,7 +40,7 @@ void ftl_cache::register_write_arrival(Event const& event)
 		e.fixed = 1;
 		e.hotness = 1;
 		e.synch_flag = false;
-		cached_mapping_table[la] = e;
+		insert(la, e);
 	}
 	else {
 		assert(false);
@@ -41,8 +52,15 @@ void ftl_cache::handle_read_dependency(Event* e) {
 		ftl_cache::entry entry;
 		entry.hotness++;
 		entry.synch_flag = true;
-		cached_mapping_table[e->get_logical_address()] = entry;
+		if (RANGE_COMPRESSION) {
+			Address pa = page_mapping->get_physical_address(e->get_logical_address());
+			entry.physical_address = pa.valid == PAGE ? pa.get_linear_address() : UNDEFINED;
+		}
+		insert(e->get_logical_address(), entry);
 		eviction_queue_clean.push(e->get_logical_address());
+		if (RANGE_COMPRESSION) {
+			cache_surrounding_range(e->get_logical_address());
+		}
 	}
 	else {
 		ftl_cache::entry& entry = cached_mapping_table.at(e->get_logical_address());
@@ -55,20 +73,24 @@ bool ftl_cache::register_read_arrival(Event* app_read) {
 	if (cached_mapping_table.count(la) == 1) {
 		ftl_cache::entry& e = cached_mapping_table.at(la);
 		e.hotness++;
+		num_hits++;
 		return true;
 	}
+	num_misses++;
 	return false;
 }
 
 void ftl_cache::register_write_completion(Event const& event) {
 	assert(!event.is_mapping_op());
+	long new_physical_address = event.get_address().get_linear_address();
 	if (event.is_garbage_collection_op() && !event.is_original_application_io()) {
 		if (cached_mapping_table.count(event.get_logical_address()) == 0) {
 			entry e;
 			e.timestamp = event.get_current_time();
 			e.dirty = true;
 			e.synch_flag = true;
-			cached_mapping_table[event.get_logical_address()] = e;
+			e.physical_address = new_physical_address;
+			insert(event.get_logical_address(), e);
 			eviction_queue_dirty.push(event.get_logical_address());
 		}
 		else {
@@ -76,6 +98,7 @@ void ftl_cache::register_write_completion(Event const& event) {
 			e.dirty = true;
 			e.timestamp = event.get_current_time();
 			e.fixed = 0;
+			set_physical_address(event.get_logical_address(), new_physical_address);
 		}
 	}
 	else if (event.is_original_application_io()) {
@@ -84,6 +107,7 @@ void ftl_cache::register_write_completion(Event const& event) {
 		e.dirty = true;
 		eviction_queue_dirty.push(event.get_logical_address());
 		e.timestamp = event.get_current_time();
+		set_physical_address(event.get_logical_address(), new_physical_address);
 	}
 	else {
 		assert(false);  // just since I'm not immediately sure what should happen here
@@ -119,7 +143,7 @@ void ftl_cache::iterate(long& victim_key, entry& victim_entry, bool allow_choosi
 }
 
 void ftl_cache::clear_clean_entries(double time) {
-	while (cached_mapping_table.size() >= CACHED_ENTRIES_THRESHOLD && erase_victim(time, false) != UNDEFINED);
+	while (get_num_slots() >= CACHED_ENTRIES_THRESHOLD && erase_victim(time, false) != UNDEFINED);
 }
 
 int ftl_cache::choose_dirty_victim(double time) {
@@ -134,7 +158,7 @@ bool ftl_cache::mark_clean(int key, double time) {
 	bool was_dirty = e.dirty;
 	assert(e.fixed >= 0);
 	if (e.timestamp <= time && e.hotness == 0 && e.fixed == 0) {
-		cached_mapping_table.erase(key);
+		erase(key);
 	}
 	else if (e.timestamp <= time && e.dirty) {
 		e.dirty = false;
@@ -200,9 +224,13 @@ int ftl_cache::erase_victim(double time, bool allow_flushing_dirty) {
 	}
 
 	// if entry is clean, just erase it. Otherwise, need some mapping IOs.
-	if (!victim_entry.dirty) {
+	if (!victim_entry.dirty && RANGE_COMPRESSION) {
+		erase_clean_range(victim);
+		return victim;
+	}
+	else if (!victim_entry.dirty) {
 		//printf("erase %d\n", victim);
-		cached_mapping_table.erase(victim);
+		erase(victim);
 		return victim;
 	}
 	return victim;
@@ -217,3 +245,104 @@ int ftl_cache::get_num_dirty_entries() const {
 	}
 	return num_dirty;
 }
+
+void ftl_cache::insert(long key, entry const& e) {
+	unlink_from_ranges(key);
+	cached_mapping_table[key] = e;
+	link_into_ranges(key);
+}
+
+void ftl_cache::erase(long key) {
+	unlink_from_ranges(key);
+	cached_mapping_table.erase(key);
+	link_into_ranges(key);
+}
+
+void ftl_cache::set_physical_address(long key, long physical_address) {
+	unlink_from_ranges(key);
+	cached_mapping_table.at(key).physical_address = physical_address;
+	link_into_ranges(key);
+}
+
+// An entry starts a new range unless the previous logical address in the same translation page
+// is cached and maps to the physical page right before this one.
+bool ftl_cache::is_range_head(long key) const {
+	auto it = cached_mapping_table.find(key);
+	if (it == cached_mapping_table.end()) {
+		return false;
+	}
+	if (key % DFTL::ENTRIES_PER_TRANSLATION_PAGE == 0) {
+		return true;
+	}
+	auto prev = cached_mapping_table.find(key - 1);
+	if (prev == cached_mapping_table.end() || prev->second.physical_address == UNDEFINED) {
+		return true;
+	}
+	return it->second.physical_address != prev->second.physical_address + 1;
+}
+
+// Changing the entry for key can only affect whether key and key + 1 start a range.
+// These two methods are called around every such change to keep num_ranges up to date.
+void ftl_cache::unlink_from_ranges(long key) {
+	if (RANGE_COMPRESSION) {
+		num_ranges -= is_range_head(key) + is_range_head(key + 1);
+	}
+}
+
+void ftl_cache::link_into_ranges(long key) {
+	if (RANGE_COMPRESSION) {
+		num_ranges += is_range_head(key) + is_range_head(key + 1);
+	}
+}
+
+// Called after a translation page has been read. Caches the run of consecutive mappings around key
+// from the translation page. Since the run shares a cache slot with key, this is free in terms of cache space.
+void ftl_cache::cache_surrounding_range(long key) {
+	long first_key = key - key % DFTL::ENTRIES_PER_TRANSLATION_PAGE;
+	long last_key = min(first_key + DFTL::ENTRIES_PER_TRANSLATION_PAGE - 1, (long)(NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR) - 1);
+	long physical_address = cached_mapping_table.at(key).physical_address;
+	if (physical_address == UNDEFINED) {
+		return;
+	}
+	for (int direction = -1; direction <= 1; direction += 2) {
+		long expected = physical_address + direction;
+		for (long i = key + direction; i >= first_key && i <= last_key && !contains(i); i += direction, expected += direction) {
+			Address pa = page_mapping->get_physical_address(i);
+			if (pa.valid != PAGE || pa.get_linear_address() != expected) {
+				break;
+			}
+			entry e;
+			e.synch_flag = true;
+			e.physical_address = expected;
+			insert(i, e);
+			eviction_queue_clean.push(i);
+		}
+	}
+}
+
+// Evicts the clean and unfixed part of the range that key belongs to, freeing its cache slot.
+void ftl_cache::erase_clean_range(long key) {
+	vector<long> victims(1, key);
+	for (long i = key; !is_range_head(i); i--) {
+		entry const& e = cached_mapping_table.at(i - 1);
+		if (e.dirty || e.fixed) break;
+		victims.push_back(i - 1);
+	}
+	for (long i = key + 1; contains(i) && !is_range_head(i); i++) {
+		entry const& e = cached_mapping_table.at(i);
+		if (e.dirty || e.fixed) break;
+		victims.push_back(i);
+	}
+	for (auto victim : victims) {
+		erase(victim);
+	}
+}
+
+void ftl_cache::print_stats() const {
+	long num_lookups = num_hits + num_misses;
+	printf("mapping cache hits\t%ld\n", num_hits);
+	printf("mapping cache misses\t%ld\n", num_misses);
+	printf("mapping cache hit rate\t%f\n", num_lookups == 0 ? 0 : num_hits / (double)num_lookups);
+	printf("mapping cache entries\t%lu\n", cached_mapping_table.size());
+	printf("mapping cache slots\t%ld\n", get_num_slots());
+}
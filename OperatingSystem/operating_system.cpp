@@ -133,6 +133,7 @@ void OperatingSystem::run() {
 		Thread* t = entry.second;
 		t->stop();
 	}
+	ssd->drain_write_cache(time);
 }
 
 void OperatingSystem::dispatch_event(int thread_id) {
@@ -8,6 +8,7 @@
 #include "../ssd.h"
 //#include "../MTRand/mtrand.h"
 #include <stdlib.h>
+#include <math.h>
 using namespace ssd;
 
 // =================  Thread =============================
@@ -242,6 +243,113 @@ void Flexible_Reader_Thread::handle_event_completion(Event* event) {
 	}
 }
 
+// =================  Zoned_Log_Writer  =============================
+
+Zoned_Log_Writer::Zoned_Log_Writer(long min_LBA, long max_LBA, int max_outstanding_ios, long num_ios, bool use_zone_append, bool trim_on_reset)
+	: Thread(),
+	  first_zone(ceil(min_LBA / (double)ZNS::get_zone_size())),
+	  num_zones(max_LBA / ZNS::get_zone_size() - first_zone),
+	  current_zone(first_zone),
+	  next_offset(0),
+	  MAX_IOS(max_outstanding_ios),
+	  number_of_times_to_repeat(num_ios),
+	  use_zone_append(use_zone_append),
+	  trim_on_reset(trim_on_reset),
+	  wrapped_around(false),
+	  resetting(false),
+	  reset_pages_issued(0),
+	  reset_pages_done(0)
+{
+	assert(num_zones > 0);
+	assert(MAX_IOS > 0);
+	assert(trim_on_reset || FTL_DESIGN != 4);
+}
+
+void Zoned_Log_Writer::generate_io() {
+	while (get_num_ongoing_IOs() < MAX_IOS && number_of_times_to_repeat > 0 && !is_finished() && !is_stopped()) {
+		if (resetting) {
+			if (reset_pages_issued == ZNS::get_zone_size()) {
+				return;
+			}
+			int trim_size = FTL_DESIGN == 4 ? ZNS::get_zone_size() : 1;
+			submit(new Event(TRIM, current_zone * ZNS::get_zone_size() + reset_pages_issued, trim_size, get_current_time()));
+			reset_pages_issued += trim_size;
+			continue;
+		}
+		if (next_offset == ZNS::get_zone_size()) {
+			next_offset = 0;
+			current_zone = first_zone + (current_zone - first_zone + 1) % num_zones;
+			wrapped_around |= current_zone == first_zone;
+			if (wrapped_around && trim_on_reset) {
+				resetting = true;
+				reset_pages_issued = reset_pages_done = 0;
+				continue;
+			}
+		}
+		long logical_addr = current_zone * ZNS::get_zone_size() + (use_zone_append ? 0 : next_offset);
+		Event* e = new Event(WRITE, logical_addr, 1, get_current_time());
+		e->set_zone_append(use_zone_append);
+		next_offset++;
+		number_of_times_to_repeat--;
+		submit(e);
+	}
+}
+
+void Zoned_Log_Writer::issue_first_IOs() {
+	generate_io();
+}
+
+void Zoned_Log_Writer::handle_event_completion(Event* event) {
+	if (event->get_event_type() == TRIM) {
+		reset_pages_done += event->get_size();
+		resetting = reset_pages_done < ZNS::get_zone_size();
+	}
+	generate_io();
+}
+
+// =================  Flushing_Random_Writer  =============================
+
+Flushing_Random_Writer::Flushing_Random_Writer(long min_LBA, long max_LBA, ulong randseed, int max_outstanding_ios, long num_ios, int fua_interval, int flush_interval)
+	: Thread(),
+	  io_gen(min_LBA, max_LBA, randseed),
+	  MAX_IOS(max_outstanding_ios),
+	  number_of_times_to_repeat(num_ios),
+	  fua_interval(fua_interval),
+	  flush_interval(flush_interval),
+	  num_writes_issued(0),
+	  flushing(false)
+{
+	assert(MAX_IOS > 0);
+}
+
+void Flushing_Random_Writer::generate_io() {
+	while (!flushing && get_num_ongoing_IOs() < MAX_IOS && number_of_times_to_repeat > 0 && !is_finished() && !is_stopped()) {
+		Event* e = new Event(WRITE, io_gen.next(), 1, get_current_time());
+		num_writes_issued++;
+		number_of_times_to_repeat--;
+		e->set_force_unit_access(fua_interval > 0 && num_writes_issued % fua_interval == 0);
+		flushing = flush_interval > 0 && num_writes_issued % flush_interval == 0;
+		submit(e);
+	}
+	// the flush is issued alone, so that it only has to wait for the writes that completed before it
+	if (flushing && get_num_ongoing_IOs() == 0 && !is_finished() && !is_stopped()) {
+		Event* flush = new Message(get_current_time());
+		flush->set_flush(true);
+		submit(flush);
+	}
+}
+
+void Flushing_Random_Writer::issue_first_IOs() {
+	generate_io();
+}
+
+void Flushing_Random_Writer::handle_event_completion(Event* event) {
+	if (event->is_flush()) {
+		flushing = false;
+	}
+	generate_io();
+}
+
 // =================  Collision_Free_Asynchronous_Random_Writer  =============================
 
 /*Collision_Free_Asynchronous_Random_Thread::Collision_Free_Asynchronous_Random_Thread(long min_LBA, long max_LBA, int num_ios_to_issue, ulong randseed, event_type type)
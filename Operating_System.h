@@ -385,6 +385,55 @@ public:
     }
 };
 
+// Asynchronous random writes, as issued by a file system that commits a journal. Every fua_interval-th write has force
+// unit access, and after every flush_interval writes the thread issues a flush and waits until it completes before it
+// writes again. With the write cache on (see WRITE_CACHE_PAGES), FUA writes bypass it, and a flush waits until the pages
+// written before it are destaged. An interval of 0 turns that kind of IO off.
+class Flushing_Random_Writer : public Thread
+{
+public:
+	Flushing_Random_Writer(long min_LBA, long max_LBA, ulong randseed, int max_outstanding_ios, long num_ios, int fua_interval, int flush_interval);
+	void issue_first_IOs();
+	void handle_event_completion(Event* event);
+private:
+	void generate_io();
+	Random_IO_Pattern io_gen;
+	int MAX_IOS;
+	long number_of_times_to_repeat;
+	int fua_interval;
+	int flush_interval;
+	long num_writes_issued;
+	bool flushing;			// a flush is outstanding, or waits for the writes before it to complete
+};
+
+// Uses the address range as a circular log of zones, like a log-structured file system on a host-managed zoned drive (see ZNS).
+// Zones are filled one after the other. Once the range wraps around, the oldest zone is reset before it is written again.
+// With zone appends, the device picks the address of each write within the current zone. On ZNS a reset is one trim of the
+// whole zone. The other FTLs only trim single pages, so there the zone is reset with a trim per page. The same thread can
+// then run on them for comparison, as long as it uses normal writes. Without trims on reset, the oldest zone is simply
+// overwritten, as by an application that does not trim on a conventional drive. ZNS rejects that.
+class Zoned_Log_Writer : public Thread
+{
+public:
+	Zoned_Log_Writer(long min_LBA, long max_LBA, int max_outstanding_ios, long num_ios, bool use_zone_append = false, bool trim_on_reset = true);
+	void issue_first_IOs();
+	void handle_event_completion(Event* event);
+private:
+	void generate_io();
+	long first_zone;
+	long num_zones;
+	long current_zone;
+	long next_offset;		// in the current zone
+	int MAX_IOS;
+	long number_of_times_to_repeat;
+	bool use_zone_append;
+	bool trim_on_reset;
+	bool wrapped_around;
+	bool resetting;
+	long reset_pages_issued;	// pages of the current zone covered by trims submitted so far
+	long reset_pages_done;		// pages of the current zone covered by trims completed so far
+};
+
 
 // This thread simulates the IO pattern of an external sort algorithm
 class External_Sort : public Thread
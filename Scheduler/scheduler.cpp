@@ -389,6 +389,7 @@ void IOScheduler::handle_write(Event* event) {
 
 	if (addr.valid == NONE && event->get_event_type() == COPY_BACK) {
 		transform_copyback(event);
+		push(event);
 	}
 	else if (addr.valid == NONE) {
 		event->incr_bus_wait_time(BUS_DATA_DELAY + BUS_CTRL_DELAY);  // actually, we never know how long to wait here. Space might clear on any LUN on the SSD any time
@@ -397,7 +398,6 @@ void IOScheduler::handle_write(Event* event) {
 	else if (!bm->can_schedule_on_die(addr, event->get_event_type(), event->get_application_io_id())) {
 		event->incr_bus_wait_time(wait_time + BUS_DATA_DELAY + BUS_CTRL_DELAY);
 		push(event);
-		assert(false);
 	}
 	else if (wait_time > 0) {
 		event->incr_bus_wait_time(wait_time);
@@ -418,6 +418,8 @@ void IOScheduler::transform_copyback(Event* event) {
 	event->set_address(event->get_replace_address());
 	Event* write = new Event(WRITE, event->get_logical_address(), 1, event->get_current_time());
 	write->set_garbage_collection_op(true);
+	write->set_wear_leveling_op(event->is_wear_leveling_op());
+	write->set_background_op(event->is_background_op());
 	write->set_replace_address(event->get_replace_address());
 	write->set_application_io_id(event->get_application_io_id());
 	dependencies[event->get_application_io_id()].push_back(write);
@@ -435,10 +437,10 @@ void IOScheduler::remove_current_operation(Event* event) {
 	event->set_noop(true);
 	if (event->get_event_type() == READ_TRANSFER) {
 		ssd->get_package(event->get_address().package)->get_die(event->get_address().die)->clear_register();
-		bm->register_register_cleared();
+		bm->register_register_cleared(event->get_address());
 	} else if (event->get_event_type() == COPY_BACK) {
 		ssd->get_package(event->get_replace_address().package)->get_die(event->get_replace_address().die)->clear_register();
-		bm->register_register_cleared();
+		bm->register_register_cleared(event->get_replace_address());
 	}
 }
 
@@ -456,6 +458,10 @@ void IOScheduler::handle_noop_events(vector<Event*>& events) {
 			e->incr_pure_ssd_wait_time(event->get_bus_wait_time() + event->get_execution_time());
 			dependents.pop_front();
 			e->set_noop(true);
+			// a read transfer gets its address when it is initialised, so one cancelled before that takes its read command's
+			if (e->get_event_type() == READ_TRANSFER && e->get_address().valid < PAGE && event->get_address().valid == PAGE) {
+				e->set_address(event->get_address());
+			}
 			inform_FTL_of_noop_completion(e);
 			complete(e);
 		}
@@ -532,6 +538,8 @@ void IOScheduler::setup_dependent_event(Event* event, Event* dependent) {
 enum status IOScheduler::execute_next(Event* event) {
 	enum status result = ssd->issue(event);
 	assert(result == SUCCESS);
+	bm->register_die_activity(event->get_address());
+	migrator->register_die_activity(*event);
 
 	if (PRINT_LEVEL > 0  /*&& event->is_original_application_io() */ /*&& (event->get_event_type() == WRITE || event->get_event_type() == ERASE *//*|| event->get_event_type() == READ_TRANSFER)*/   /* && event->is_garbage_collection_op() && (event->get_event_type() == WRITE || event->get_event_type() == ERASE)*/ ) {
 		event->print();
@@ -598,6 +606,10 @@ enum status IOScheduler::execute_next(Event* event) {
 	if (event->get_event_type() == READ_TRANSFER && event->is_garbage_collection_op()) {
 		trigger_next_migration(event);
 	}
+	// a copy back has no read transfer, so the next migration of its block starts once it is done
+	else if (event->get_event_type() == COPY_BACK && event->is_garbage_collection_op()) {
+		resume_migrations(event->get_replace_address(), event->get_current_time());
+	}
 
 	int dependency_code = event->get_application_io_id();
 	if (dependencies[dependency_code].size() > 0) {
@@ -753,6 +765,11 @@ void IOScheduler::init_event(Event* event) {
 	else if (type == ERASE) {
 		push(event);
 	}
+	else if (type == MESSAGE && event->is_flush()) {
+		// without a write cache, every completed write is already in flash
+		event->set_noop(true);
+		completed_events->push(event);
+	}
 	else if (type == MESSAGE) {
 		bm->receive_message(*event);
 		completed_events->push(event);
@@ -792,6 +809,15 @@ void IOScheduler::trigger_next_migration(Event* event) {
 	}
 }
 
+// Starts the next migration of a block whose last migration had no read transfer, or whose garbage-collection was
+// paused, see Migrator::more_migrations
+void IOScheduler::resume_migrations(Address const& page_address, double time) {
+	Event resume(READ_TRANSFER, 0, 1, time);
+	resume.set_address(page_address);
+	resume.set_garbage_collection_op(true);
+	trigger_next_migration(&resume);
+}
+
 void IOScheduler::try_to_put_in_safe_cache(Event* write) {
 	if (safe_cache.has_space() && !safe_cache.exists(write->get_logical_address()) && !write->is_garbage_collection_op() && write->is_original_application_io()) {
 		safe_cache.insert(write->get_logical_address());
@@ -850,12 +876,15 @@ void IOScheduler::remove_redundant_events(Event* new_event) {
 		remove_event_from_current_events(existing_event); // Remove old event from current_events; it's added again when independent event (the copy back) finishes
 	}
 	else */
-	if (new_event->get_logical_address() == 37796 || existing_event->get_logical_address() == 37796) {
-		int i = 0;
-		i++;
-	}
 
-	if (IS_FTL_PAGE_MAPPING && new_event->is_garbage_collection_op() && scheduled_op_code == WRITE) {
+	// The write is being dispatched, and so is in neither queue. Like a trim, it makes the migration redundant.
+	if (IS_FTL_PAGE_MAPPING && new_event->is_garbage_collection_op() && scheduled_op_code == WRITE && existing_event == NULL) {
+		remove_current_operation(new_event);
+		push(new_event);
+		bm->register_trim_making_gc_redundant(new_event);
+		LBA_currently_executing[common_logical_address] = dependency_code_of_other_event;
+	}
+	else if (IS_FTL_PAGE_MAPPING && new_event->is_garbage_collection_op() && scheduled_op_code == WRITE) {
 		promote_to_gc(existing_event);
 		remove_current_operation(new_event);
 		push(new_event); // Make sure the old GC READ is run, even though it is now a NOOP command
@@ -899,12 +928,8 @@ void IOScheduler::remove_redundant_events(Event* new_event) {
 		LBA_currently_executing[common_logical_address] = dependency_code_of_new_event;
 		//make_dependent(new_event, dependency_code_of_new_event, dependency_code_of_other_event);
 	}
-	else if (new_op_code == COPY_BACK && scheduled_op_code == READ && existing_event != NULL) { // 3
-		remove_current_operation(existing_event);
-		LBA_currently_executing[common_logical_address] = dependency_code_of_new_event;
-	}
 	// if there is a write, but before a read was scheduled, we should read first before making the write
-	else if (new_op_code == WRITE && (scheduled_op_code == READ || scheduled_op_code == READ_COMMAND || scheduled_op_code == READ_TRANSFER)) { // 4
+	else if ((new_op_code == WRITE || new_op_code == COPY_BACK) && (scheduled_op_code == READ || scheduled_op_code == READ_COMMAND || scheduled_op_code == READ_TRANSFER)) { // 4
 		//assert(false);
 		make_dependent(new_event, dependency_code_of_other_event);
 	}
@@ -0,0 +1,24 @@
+#include "../ssd.h"
+using namespace ssd;
+
+// Sized with the usual formulas for the number of bits and hashes. The bits are rounded up to whole 512-bit blocks.
+blocked_bloom_filter::blocked_bloom_filter(bloom_parameters const& parameters) :
+	num_blocks(1),
+	num_hashes(1),
+	bits()
+{
+	double n = max(parameters.projected_element_count, 1ULL);
+	double p = min(max(parameters.false_positive_probability, 1e-9), 0.5);
+	double m = ceil(-n * log(p) / (log(2.0) * log(2.0)));
+	num_blocks = max((ulong)ceil(m / (WORDS_PER_BLOCK * 64)), 1UL);
+	num_hashes = min(max((int)round(m / n * log(2.0)), 1), 16);
+	bits = vector<ulong>(num_blocks * WORDS_PER_BLOCK, 0);
+}
+
+void blocked_bloom_filter::clear() {
+	fill(bits.begin(), bits.end(), 0);
+}
+
+void blocked_bloom_filter::insert_all_keys() {
+	fill(bits.begin(), bits.end(), ~0UL);
+}
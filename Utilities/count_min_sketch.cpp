@@ -0,0 +1,27 @@
+#include "../ssd.h"
+using namespace ssd;
+
+count_min_sketch::count_min_sketch(int width, int depth) :
+	width(max(width, 1)),
+	depth(max(depth, 1)),
+	counters(this->width * this->depth, 0),
+	total(0)
+{}
+
+void count_min_sketch::add(ulong key) {
+	uint count = estimate(key);
+	for (int row = 0; row < depth; row++) {
+		uint& counter = counters[get_index(key, row)];
+		if (counter == count) {
+			counter++;
+		}
+	}
+	total++;
+}
+
+void count_min_sketch::halve() {
+	for (uint& counter : counters) {
+		counter >>= 1;
+	}
+	total /= 2;
+}
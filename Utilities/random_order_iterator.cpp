@@ -34,3 +34,43 @@ vector<int> Random_Order_Iterator::get_iterator(int needed_length) {
 	shuffle(order);
 	return order;
 }
+
+MTRand_int32 Random_Permutation::random_number_generator = MTRand_int32(23652362462462462);
+
+Random_Permutation::Random_Permutation(int n) :
+	n(n),
+	mask(0),
+	shift(1),
+	counter(random_number_generator()),
+	remaining(n)
+{
+	int bits = 0;
+	while ((1u << bits) < n) {
+		bits++;
+	}
+	mask = (1u << bits) - 1;
+	shift = bits / 2 + 1;
+	for (int i = 0; i < NUM_ROUNDS; i++) {
+		multipliers[i] = random_number_generator() | 1;
+		increments[i] = random_number_generator();
+	}
+}
+
+// Each step is a bijection on [0, 2^k), so the composition is too
+uint Random_Permutation::permute(uint x) const {
+	for (int i = 0; i < NUM_ROUNDS; i++) {
+		x = (x * multipliers[i] + increments[i]) & mask;
+		x ^= x >> shift;
+	}
+	return x;
+}
+
+int Random_Permutation::next() {
+	assert(remaining > 0);
+	remaining--;
+	uint value;
+	do {
+		value = permute(counter++ & mask);
+	} while (value >= n);
+	return value;
+}
@@ -21,6 +21,10 @@ StatisticsGatherer::StatisticsGatherer()
 	: num_gc_cancelled_no_candidate(0),
 	  num_gc_cancelled_not_enough_free_space(0),
 	  num_gc_cancelled_gc_already_happening(0),
+	  num_gc_triggered_out_of_space(0),
+	  num_gc_triggered_write_blocked(0),
+	  num_gc_triggered_low_free_blocks(0),
+	  num_gc_triggered_below_watermark(0),
 	  bus_wait_time_for_reads_per_LUN(SSD_SIZE, vector<vector<double> >(PACKAGE_SIZE, vector<double>())),
 	  num_reads_per_LUN(SSD_SIZE, vector<uint>(PACKAGE_SIZE, 0)),
 	  num_mapping_reads_per_LUN(SSD_SIZE, vector<uint>(PACKAGE_SIZE, 0)),
@@ -548,6 +552,11 @@ void StatisticsGatherer::print_gc_info() {
 	printf("num_gc_cancelled_no_candidate: %ld \n", num_gc_cancelled_no_candidate);
 	printf("num_gc_cancelled_not_enough_free_space: %ld \n", num_gc_cancelled_not_enough_free_space);
 	printf("num_gc_cancelled_gc_already_happening: %ld \n", num_gc_cancelled_gc_already_happening);
+	printf("\n");
+	printf("num_gc_triggered_out_of_space: %ld \n", num_gc_triggered_out_of_space);
+	printf("num_gc_triggered_write_blocked: %ld \n", num_gc_triggered_write_blocked);
+	printf("num_gc_triggered_low_free_blocks: %ld \n", num_gc_triggered_low_free_blocks);
+	printf("num_gc_triggered_below_watermark: %ld \n", num_gc_triggered_below_watermark);
 }
 
 
@@ -0,0 +1,30 @@
+#include "../ssd.h"
+using namespace ssd;
+
+// The number of leaves is rounded up to a power of two. The padding leaves hold the largest possible key and so never win.
+Tournament_Tree::Tournament_Tree(int size) :
+	num_leaves(1),
+	keys(),
+	winners()
+{
+	while (num_leaves < size) {
+		num_leaves *= 2;
+	}
+	keys = vector<double>(num_leaves, numeric_limits<double>::max());
+	winners = vector<int>(2 * num_leaves, 0);
+	for (int i = 0; i < num_leaves; i++) {
+		winners[num_leaves + i] = i;
+	}
+	for (int node = num_leaves - 1; node >= 1; node--) {
+		winners[node] = winners[2 * node];
+	}
+}
+
+void Tournament_Tree::update(int index, double key) {
+	keys[index] = key;
+	for (int node = (num_leaves + index) / 2; node >= 1; node /= 2) {
+		int left = winners[2 * node];
+		int right = winners[2 * node + 1];
+		winners[node] = keys[left] <= keys[right] ? left : right;
+	}
+}
@@ -109,6 +109,21 @@ vector<Thread*> Init_Workload::generate() {
 	return threads;
 }
 
+//*****************************************************************************************
+//				Random writes with FUA and flushes
+//*****************************************************************************************
+
+Flushing_Random_Workload::Flushing_Random_Workload(long num_writes, int fua_interval, int flush_interval)
+	: num_writes(num_writes), fua_interval(fua_interval), flush_interval(flush_interval) {}
+
+vector<Thread*> Flushing_Random_Workload::generate() {
+	Simple_Thread* init_write = new Asynchronous_Sequential_Writer(min_lba, max_lba);
+	Thread* thread = new Flushing_Random_Writer(min_lba, max_lba, 6317, MAX_SSD_QUEUE_SIZE * 2, num_writes, fua_interval, flush_interval);
+	init_write->add_follow_up_thread(thread);
+	vector<Thread*> threads(1, init_write);
+	return threads;
+}
+
 //*****************************************************************************************
 //				Sequentail write to calibrate the SSD
 //*****************************************************************************************
@@ -20,16 +20,20 @@ public:
 	~Migrator();
 	void init(IOScheduler*, Block_manager_parent*, Garbage_Collector*, Wear_Leveling_Strategy*, FtlParent*, Ssd*);
 	void schedule_gc(double time, int package, int die, int block, int klass);
+	void schedule_gc(double time, Address const& address, int klass);
+	void schedule_wear_leveling(double time, Address const& block_address);
 	vector<deque<Event*> > migrate(Event * gc_event);
 	void update_structures(Address const& a, double time);
+	void erase_discarded_block(Address const& a, double time);
 	void print_pending_migrations();
 	deque<Event*> trigger_next_migration(Event * gc_read);
 	bool more_migrations(Event * gc_read);
 	void register_event_completion(Event* event);
-	void register_ECC_check_on(uint logical_address);
+	void register_die_activity(Event const& event);
 	uint how_many_gc_operations_are_scheduled() const;
 	void set_block_manager(Block_manager_parent* b) { bm = b; }
 	Garbage_Collector* get_garbage_collector() { return gc; }
+	double get_last_foreground_activity(int package, int die) const { return last_foreground_activity[package * PACKAGE_SIZE + die]; }
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
@@ -42,24 +46,45 @@ public:
     	ar & wl;
     }
 private:
-	bool copy_back_allowed_on(long logical_address);
-	void register_copy_back_operation_on(uint logical_address);
+	bool copy_back_allowed_on(Address const& page_address);
 	void handle_erase_completion(Event* event);
+	void handle_copy_back_completion(Event* event);
 	void handle_trim_completion(Event* event);
 	void issue_erase(Address ra, double time);
+	int get_free_block_deficit(int package, int die) const;
+	int get_lun_budget(int package, int die) const;
+	int get_channel_budget(int package) const;
+	int get_num_gc_operations_in_channel(int package) const;
+	void schedule_background_gc(double time, int lun);
+	bool should_garbage_collect_in_background(Address const& lun_address, double time);
+	void resume_background_gc(int lun, double time);
+	void promote_background_gc(int lun, double time);
 	IOScheduler *scheduler;
 	Block_manager_parent* bm;
 	Ssd* ssd;
 	FtlParent* ftl;
 	Garbage_Collector* gc;
 	Wear_Leveling_Strategy* wl;
-	map<long, uint> page_copy_back_count; // Pages that have experienced a copy-back, mapped to a count of the number of copy-backs
+	vector<unsigned char> copy_back_generation; // per physical page, how many times its data has been copied back since it last went through the controller
 	vector<vector<uint> > num_blocks_being_garbaged_collected_per_LUN;
 	unordered_map<int, int> blocks_being_garbage_collected;
 	vector<queue<Event*> > erase_queue;
 	vector<int> num_erases_scheduled_per_package;
 	unordered_map<long, vector<deque<Event*> > > dependent_gc;
 	unordered_map<Block*, double> gc_time_stat;
+
+	// Background garbage-collection, per LUN. A background operation pauses between migrations when an application IO
+	// is issued to its LUN, and resumes once the LUN is idle again, or right away if foreground garbage-collection needs the LUN.
+	vector<long> num_foreground_ios;				// application IOs issued so far
+	vector<double> last_foreground_activity;		// when the last application IO issued to the LUN finishes there
+	vector<bool> background_gc_check_scheduled;
+	vector<long> background_gc_block;				// block ID, or UNDEFINED
+	vector<long> num_foreground_ios_at_resume;		// the background operation pauses once this changes
+	vector<bool> background_gc_paused;
+	long num_foreground_gc_ops, num_background_gc_ops;
+	long num_foreground_gc_migrations, num_background_gc_migrations;
+	long num_background_gc_preemptions, num_background_gc_promotions;
+	long num_copy_back_migrations, num_copy_backs, num_copy_backs_refused_for_ECC;
 };
 
 class Block_manager_parent {
@@ -71,33 +96,41 @@ public:
 	virtual void register_read_command_outcome(Event const& event, enum status status);
 	virtual void register_read_transfer_outcome(Event const& event, enum status status);
 	virtual void register_erase_outcome(Event& event, enum status status);
-	virtual void register_register_cleared();
+	virtual void register_register_cleared(Address const& die_address);
+	void register_die_activity(Address const& die_address);
 	virtual Address choose_write_address(Event& write);
 	Address choose_flexible_read_address(Flexible_Read_Event* fr);
 	virtual void register_write_arrival(Event const& write);
 	virtual void trim(Event const& write);
 	virtual void receive_message(Event const& message) {}
-	double in_how_long_can_this_event_be_scheduled(Address const& die_address, double current_time, event_type type = NOT_VALID) const;
+	double in_how_long_can_this_event_be_scheduled(Address const& die_address, double current_time, event_type type = NOT_VALID);
 	double soonest_possible_write() const;
 	static double soonest_write_time;
-	double in_how_long_can_this_write_be_scheduled(double current_time) const;
+	double in_how_long_can_this_write_be_scheduled(double current_time);
 	double in_how_long_can_this_write_be_scheduled2(double current_time) const;
-	void update_next_possible_write_time() const;
+	void update_next_possible_write_time();
 	vector<deque<Event*> > migrate(Event * gc_event);
 	bool Copy_backs_in_progress(Address const& address);
 	bool can_schedule_on_die(Address const& address, event_type type, uint app_io_id) const;
 	bool is_die_register_busy(Address const& addr) const;
 	void register_trim_making_gc_redundant(Event* trim);
 	Address choose_copbyback_address(Event const& write);
+	virtual bool may_copy_back(Address const& page_address) const { return true; }
 	void schedule_gc(double time, int package_id, int die_id, int block, int klass);
 	virtual void check_if_should_trigger_more_GC(Event const& event);
 	double get_average_migrations_per_gc() const;
 	int get_num_age_classes() const { return num_age_classes; }
 	int get_num_pages_available_for_new_writes() const { return num_available_pages_for_new_writes; }
+	int get_num_free_blocks(int package, int die) const { return num_free_blocks_per_lun[package * PACKAGE_SIZE + die]; }
 	void subtract_from_available_for_new_writes(int num) {
 		num_available_pages_for_new_writes -= num;
 		//printf("%d   %d\n", num_available_pages_for_new_writes, num_free_pages);
 	}
+	// for blocks that are erased before they were filled, e.g. on a zone reset
+	void discard_unwritten_pages(int num) {
+		num_free_pages -= num;
+		num_available_pages_for_new_writes -= num;
+	}
 	vector<Block*> const& get_all_blocks() const { return all_blocks; }
 	uint sort_into_age_class(Address const& address) const;
 	void copy_state(Block_manager_parent* bm);
@@ -114,6 +147,8 @@ public:
     	ar & free_block_pointers;
 
     	ar & free_blocks;
+    	ar & non_empty_age_classes;
+    	ar & num_free_blocks_per_lun;
     	ar & all_blocks;
     	ar & num_age_classes;
     	ar & num_free_pages;
@@ -141,6 +176,11 @@ protected:
 	bool can_schedule_write_immediately(Address const& prospective_dest, double current_time);
 	bool can_write(Event const& write) const;
 	Address get_free_block_pointer_with_shortest_IO_queue();
+	virtual void handle_block_pointer_out_of_space(uint package, uint die, double time);
+	// Must be called when a free block pointer changes outside of the callbacks for the IOs on its LUN
+	void mark_lun_for_update(int package, int die);
+	// A LUN is below its GC watermark if its free block pointer is full or it has fewer than GREED_SCALE free blocks
+	void update_gc_watermark(int package, int die);
 
 	inline bool has_free_pages(Address const& address) const { return address.valid == PAGE && address.page < BLOCK_SIZE; }
 
@@ -149,19 +189,17 @@ protected:
 	IOScheduler *scheduler;
 	vector<vector<Address> > free_block_pointers;
 	Migrator* migrator;
-	vector<vector<vector<deque<Address> > > > free_blocks;  // package -> die -> class -> list of such free blocks
+	// Free blocks are kept in a flat array of pools, one per LUN and age class. See get_pool_id.
+	vector<vector<Address> > free_blocks;
+	void add_free_block(Address const& block_address, uint age_class);
 
-	int get_num_free_blocks(int package, int die) const;
 	int get_num_pointers_with_free_space() const;
 	int get_num_available_pages_for_new_writes() const { return num_available_pages_for_new_writes; }
 private:
 	Address find_free_unused_block(uint package_id, uint die_id, uint age_class, double time);
+	inline int get_pool_id(uint package_id, uint die_id, uint age_class) const { return (package_id * PACKAGE_SIZE + die_id) * num_age_classes + age_class; }
 	void issue_erase(Address a, double time);
 
-
-	bool copy_back_allowed_on(long logical_address);
-	void register_copy_back_operation_on(uint logical_address);
-	void register_ECC_check_on(uint logical_address);
 	bool schedule_queued_erase(Address location);
 
 	vector<Block*> all_blocks;
@@ -174,8 +212,28 @@ private:
 	uint num_free_pages;
 	uint num_available_pages_for_new_writes;
 
-	pair<bool, pair<int, int> > last_get_free_block_pointer_with_shortest_IO_queue_result;
-	bool IO_has_completed_since_last_shortest_queue_search;
+	// Bit k is set for a LUN if its pool for age class k is non-empty, so the youngest or oldest class with a free block is found in O(1)
+	vector<unsigned long long> non_empty_age_classes;
+	vector<int> num_free_blocks_per_lun;
+	static MTRand_int32 random_number_generator;	// picks the age class of a new free block
+
+	set<int> luns_below_gc_watermark;	// LUN ids, package * PACKAGE_SIZE + die
+
+	// Index for get_free_block_pointer_with_shortest_IO_queue. A die's key is the time its current IO finishes,
+	// or the largest double if it has no free block pointer or its register is busy. A package's key is the later
+	// of its channel's finish time and the smallest key among its dies. LUNs are refreshed lazily before each search.
+	void update_lun_availability();
+	vector<Tournament_Tree> die_availability;
+	Tournament_Tree package_availability;
+	// Index for in_how_long_can_this_write_be_scheduled, maintained along with the one above. Dies are split by whether
+	// their register is busy, since a busy register delays a write by a further bus transfer.
+	// A package's key is the soonest time a write could start on any of its dies.
+	vector<Tournament_Tree> idle_register_dies;
+	vector<Tournament_Tree> busy_register_dies;
+	Tournament_Tree soonest_write_per_package;
+	long num_write_scheduling_queries;	// how often the scheduler asked when a write can be issued
+	vector<vector<bool> > lun_needs_update;
+	vector<pair<int, int> > luns_to_update;
 
 	vector<queue<Event*> > erase_queue;
 	vector<int> num_erases_scheduled_per_package;
@@ -190,21 +248,26 @@ class Wear_Leveling_Strategy {
 public:
 	Wear_Leveling_Strategy();
 	Wear_Leveling_Strategy(Ssd* ssd, Migrator*);
-	~Wear_Leveling_Strategy() {};
+	~Wear_Leveling_Strategy();
 	void register_erase_completion(Event const& event);
-	bool schedule_wear_leveling_op(Block* block);
+	void register_event_completion(Event const& event);
+	bool may_wear_level(Address const& block_address, double time);
+	bool is_urgent() const;
+	void retry_wear_leveling(Address const& block_address, double time);
+	bool schedule_wear_leveling_op(Block* block, double time);
 	double get_normalised_age(uint age) const;
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
     {
-    	ar & age_distribution;
+    	ar & blocks_of_age;
+    	ar & position_in_age;
+    	ar & min_age;
     	ar & all_blocks;
     	ar & num_erases_up_to_date;
     	ar & ssd;
     	ar & average_erase_cycle_time;
     	ar & blocks_being_wl;
-    	ar & blocks_to_wl;
     	ar & migrator;
 
     	ar & max_age;
@@ -214,16 +277,36 @@ private:
     void init();
 	double get_min_age() const;
 	//void update_blocks_with_min_age(uint min_age);
-	void find_wl_candidates(double current_time);
+	Block* choose_wl_candidate(double current_time);
+	bool is_wl_candidate(int block_id, double current_time) const;
 	//set<Block*> blocks_with_min_age;
-	map<int, int> age_distribution;  // maps block ages to the number of blocks with this age
+	// The blocks of each age, whose sizes are the age histogram. Ages only grow, so the minimum age is kept by moving it up
+	// past empty ages, and a random young block is found by indexing into the buckets of the youngest ages.
+	vector<vector<int> > blocks_of_age;	// [age] -> block IDs
+	vector<int> position_in_age;		// [block ID] -> index in blocks_of_age
+	int min_age;
 	vector<Block*> all_blocks;
 	int num_erases_up_to_date;
 	Ssd* ssd;
 	double average_erase_cycle_time;
 	set<Block*> blocks_being_wl;
-	set<Block*> blocks_to_wl;
 	Migrator* migrator;
+	// Wear-leveling is rate-limited by a bucket of page tokens, refilled at WEAR_LEVELING_PAGES_PER_SECOND and holding a block's worth
+	double page_tokens;
+	double last_token_refill;
+	bool wl_op_scheduled;				// a wear-leveling operation is waiting to start
+	double wl_op_first_scheduled;
+	// A cancelled operation waits for the next erase, which may free the GC budget, free space or the block it needs
+	bool wl_op_waiting_for_erase;
+	Address waiting_wl_op;
+	int num_retries_of_wl_op;
+	vector<int> num_wl_ops_per_lun;
+	long num_wl_ops, num_urgent_wl_ops, num_wl_pages, num_idle_deferrals, num_budget_deferrals, num_wl_retries, num_wl_ops_given_up;
+	int max_spread;
+	double total_wl_deferral_time;
+	// Latencies, to bound the impact of wear-leveling on application IOs in the LUNs it runs in
+	long num_wl_ios, num_foreground_ios_during_wl, num_other_foreground_ios;
+	double wl_io_latency, foreground_latency_during_wl, other_foreground_latency;
 	int max_age;
 	MTRand_int32 random_number_generator;
 	struct Block_data {
@@ -268,6 +351,7 @@ public:
 	void check_if_should_trigger_more_GC(Event const& event);
 	void register_erase_outcome(Event& event, enum status status);
 	bool may_garbage_collect_this_block(Block* block, double current_time);
+	bool may_copy_back(Address const& page_address) const { return false; } // a victim's pages go to the block set aside for it
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
@@ -341,11 +425,49 @@ private:
 	bool channel_alternation;
 };
 
+// A BM that opens one block per LUN at a time as a stripe (a superblock) and fills the stripe in a round-robin fashion.
+// A new stripe is only opened once every block of the current one is full. When GC picks a block from a full stripe,
+// the other blocks of the stripe are garbage-collected and erased along with it.
+class Block_manager_superblock : public Block_manager_parent {
+public:
+	Block_manager_superblock();
+	~Block_manager_superblock();
+	void init(Ssd*, FtlParent*, IOScheduler*, Garbage_Collector*, Wear_Leveling_Strategy*, Migrator*);
+	void register_write_outcome(Event const& event, enum status status);
+	void register_erase_outcome(Event& event, enum status status);
+	void check_if_should_trigger_more_GC(Event const& event);
+	bool may_garbage_collect_this_block(Block* block, double current_time);
+	bool may_copy_back(Address const& page_address) const { return false; } // migrated pages are striped like other writes
+protected:
+	Address choose_best_address(Event& write);
+	Address choose_any_address(Event const& write);
+	void handle_block_pointer_out_of_space(uint package, uint die, double time);
+private:
+	struct stripe {
+		vector<Address> blocks;
+		int num_blocks_not_erased;
+		bool being_garbage_collected;
+		stripe() : blocks(), num_blocks_not_erased(0), being_garbage_collected(false) {}
+	};
+	void open_new_stripe(double time);
+	int get_new_stripe_id();
+	vector<stripe> stripes;
+	vector<int> free_stripe_ids;
+	vector<int> stripe_of_block;	// indexed by block id, UNDEFINED for blocks that are not part of a stripe
+	int open_stripe;
+	set<long> blocks_awaiting_gc;	// the remaining blocks of stripes being garbage-collected, by block id
+	int cursor;	// the next LUN to write to. Consecutive LUNs are on different channels.
+	long num_stripes_opened;
+	long num_partial_stripes;
+	long num_stripe_gcs;
+};
+
 // A BM that assigns each write to the die with the shortest queue, as well as hot-cold seperation
 class Shortest_Queue_Hot_Cold_BM : public Block_manager_parent {
 public:
 	Shortest_Queue_Hot_Cold_BM();
 	~Shortest_Queue_Hot_Cold_BM();
+	void init(Ssd*, FtlParent*, IOScheduler*, Garbage_Collector*, Wear_Leveling_Strategy*, Migrator*);
 	void register_write_outcome(Event const& event, enum status status);
 	void register_read_command_outcome(Event const& event, enum status status);
 	void register_erase_outcome(Event& event, enum status status);
@@ -355,7 +477,7 @@ protected:
 	void check_if_should_trigger_more_GC(Event const& event);
 private:
 	void handle_cold_pointer_out_of_space(double start_time);
-	BloomFilter_Page_Hotness_Measurer page_hotness_measurer;
+	Page_Hotness_Measurer* page_hotness_measurer;
 	Address cold_pointer;
 };
 
@@ -389,11 +511,13 @@ struct sequential_writes_tracking {
 	int counter, num_times_pattern_has_repeated;
 	long key;
 	double last_arrival_timestamp;
-	double const init_timestamp;
+	double init_timestamp;
 	ulong last_io_num;
 	sequential_writes_tracking(double time, long key);
 };
 
+// Streams live in a fixed number of slots, linked from the most to the least recently written.
+// A stream is found by its first LBA or by the next LBA it expects. When all slots are taken, the least recently written stream is replaced.
 class Sequential_Pattern_Detector {
 public:
 	typedef ulong logical_address;
@@ -402,13 +526,21 @@ public:
 	sequential_writes_tracking const& register_event(logical_address lb, double time);
 	void set_listener(Sequential_Pattern_Detector_Listener * listener);
 	void remove_old_sequential_writes_metadata(double time);
+	static int STREAM_TABLE_SIZE;	// the maximum number of streams tracked at once
+	static int MAX_IDLE_IOS;		// a stream is forgotten if it has not been written during this many IOs
 private:
-	map<logical_address, logical_address> sequential_writes_key_lookup;  // a map from the next expected LBA in a seqeuntial pattern to the first LBA, which is the key
-	map<logical_address, sequential_writes_tracking*> sequential_writes_identification_and_data;	// a map from the first logical write of a sequential pattern to metadata about the pattern
-	sequential_writes_tracking* restart_pattern(int key, double time);
-	sequential_writes_tracking* process_next_write(int lb, double time);
+	unordered_map<logical_address, int> sequential_writes_key_lookup;  // a map from the next expected LBA in a sequential pattern to the slot of the pattern
+	unordered_map<logical_address, int> sequential_writes_identification_and_data;	// a map from the first logical write of a sequential pattern to the slot of the pattern
+	vector<sequential_writes_tracking> streams;
+	vector<int> lru_prev, lru_next;
+	int lru_head, lru_tail;
+	vector<int> free_slots;
+	sequential_writes_tracking* restart_pattern(int slot, double time);
+	sequential_writes_tracking* process_next_write(int lb, int slot, double time);
 	sequential_writes_tracking* init_pattern(int lb, double time);
-	uint registration_counter;
+	void remove_pattern(int slot, double time);
+	void move_to_front(int slot);
+	void unlink(int slot);
 	Sequential_Pattern_Detector_Listener* listener;
 	uint threshold;
 	ulong io_num;
@@ -451,7 +583,17 @@ private:
 		bool is_finished() {	return num_written == size; }
 	};
 
-	map<long, sequential_writes_pointers> seq_write_key_to_pointers_mapping;
+	unordered_map<long, sequential_writes_pointers> seq_write_key_to_pointers_mapping;
+
+	// maps the block IDs of the sequential write pointers to the key and index of their pointer, so a completed write is matched in O(1)
+	struct pointer_owner {
+		long key;
+		int package, die;
+		pointer_owner() : key(UNDEFINED), package(UNDEFINED), die(UNDEFINED) {}
+		pointer_owner(long key, int package, int die) : key(key), package(package), die(die) {}
+	};
+	unordered_map<long, pointer_owner> pointer_owners;
+	void set_pointer(long key, int package, int die, Address const& block);
 
 	void set_pointers_for_sequential_write(long key, double time);
 	void set_pointers_for_tagged_sequential_write(int tag, double time);
@@ -466,7 +608,7 @@ private:
 	strategy strat;
 
 	map<long, tagged_sequential_write> tag_map; // maps from tags of sequential writes to the size of the sequential write
-	map<long, long> arrived_writes_to_sequential_key_mapping;
+	unordered_map<long, long> arrived_writes_to_sequential_key_mapping;
 
 	void print_tags(); // to be removed
 	MTRand_int32 random_number_generator;
@@ -476,9 +618,10 @@ private:
 
 class Garbage_Collector {
 public:
-	Garbage_Collector() : ssd(NULL), bm(NULL), num_age_classes(1) {}
-	Garbage_Collector(Ssd* ssd, Block_manager_parent* bm) : ssd(ssd), bm(bm), num_age_classes(bm->get_num_age_classes()) {}
-	virtual ~Garbage_Collector() {}
+	Garbage_Collector() : ssd(NULL), bm(NULL), num_age_classes(1), policy_name(NULL), num_host_writes(0), num_gc_writes(0) {}
+	Garbage_Collector(Ssd* ssd, Block_manager_parent* bm, const char* policy_name = NULL)
+		: ssd(ssd), bm(bm), num_age_classes(bm->get_num_age_classes()), policy_name(policy_name), num_host_writes(0), num_gc_writes(0) {}
+	virtual ~Garbage_Collector();
 	virtual void register_event_completion(Event const& event) {};
 	virtual Block* choose_gc_victim(int package_id, int die_id, int klass) const = 0;
 	virtual void commit_choice_of_victim(Address const& phys_address, double time) = 0;
@@ -491,11 +634,18 @@ public:
     	ar & ssd;
     	ar & bm;
     	ar & num_age_classes;
+    	ar & num_host_writes;
+    	ar & num_gc_writes;
     }
 protected:
+	// Counts the flash writes of host and garbage-collection IOs, to report the write amplification of the policy
+	void count_write(Event const& event);
 	Ssd* ssd;
 	Block_manager_parent* bm;
 	int num_age_classes;
+	const char* policy_name;
+	long num_host_writes;
+	long num_gc_writes;
 };
 
 // The garbage collector organizes blocks in a data structure that is convenient for choosing which block to garbage-collect next
@@ -508,7 +658,7 @@ protected:
 class Garbage_Collector_Greedy : public Garbage_Collector {
 public:
 	Garbage_Collector_Greedy();
-	Garbage_Collector_Greedy(Ssd* ssd, Block_manager_parent* bm);
+	Garbage_Collector_Greedy(Ssd* ssd, Block_manager_parent* bm, const char* policy_name = "greedy");
 	// Called by the block manager after any page in the SSD is invalidated, as a result of a trim or a write.
 	// This is used to keep the gc_candidates structure updated.
 	virtual void register_event_completion(Event const& event);
@@ -522,11 +672,77 @@ public:
     void serialize(Archive & ar, const unsigned int version)
     {
     	ar & boost::serialization::base_object<Garbage_Collector>(*this);
-    	ar & gc_candidates;
+    	ar & first_in_bucket; ar & last_in_bucket; ar & non_empty_buckets; ar & num_candidates;
+    	ar & bucket_of_block; ar & next_in_bucket; ar & previous_in_bucket; ar & time_of_last_change;
+    	ar & current_time;
+    }
+protected:
+	inline int get_lun(Address const& a) const { return a.package * PACKAGE_SIZE + a.die; }
+	inline bool may_be_collected(Block* block) const { return block->get_state() == ACTIVE || block->get_state() == INACTIVE; }
+	Block* get_block(long block_id) const;
+	// Victims of different LUNs are compared by this priority. Greedy prefers the block with the fewest valid pages.
+	virtual double get_priority(long block_id) const;
+	virtual Block* choose_gc_victim_in_lun(int lun) const;
+	virtual void insert(long block_id, int lun, int num_valid_pages);
+	virtual void remove(long block_id, int lun);
+	// Candidates of each LUN are kept in buckets by their number of valid pages, with a bit per non-empty bucket,
+	// so choosing a victim takes the lowest set bit instead of a scan over all blocks of the LUN.
+	// Each bucket is a list ordered by the time its blocks last changed, with the oldest first.
+	vector<vector<long> > first_in_bucket;		// [lun][valid pages] -> block ID, or UNDEFINED
+	vector<vector<long> > last_in_bucket;		// [lun][valid pages] -> block ID, or UNDEFINED
+	vector<vector<ulong> > non_empty_buckets;	// [lun] -> a bit per bucket
+	vector<int> num_candidates;					// [lun]
+	vector<int> bucket_of_block;				// [block ID] -> number of valid pages, or UNDEFINED if the block is not a candidate
+	vector<long> next_in_bucket;				// [block ID]
+	vector<long> previous_in_bucket;			// [block ID]
+	vector<double> time_of_last_change;			// [block ID] -> when the block was last written or had a page invalidated
+	double current_time;
+private:
+	void link(long block_id, int lun, int num_valid_pages);
+	void unlink(long block_id, int lun);
+	void update(Address const& a);
+};
+
+// Cost-benefit picks the block with the highest age * (1 - u) / 2u, where u is the fraction of valid pages and the age
+// is the time since the block last changed. Within a bucket of the greedy index, the oldest block has the highest score,
+// so only the first collectable block of each bucket is considered, and choosing a victim costs O(BLOCK_SIZE) per LUN.
+class Garbage_Collector_Cost_Benefit : public Garbage_Collector_Greedy {
+public:
+	Garbage_Collector_Cost_Benefit() : Garbage_Collector_Greedy() {}
+	Garbage_Collector_Cost_Benefit(Ssd* ssd, Block_manager_parent* bm) : Garbage_Collector_Greedy(ssd, bm, "cost-benefit") {}
+	friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+    	ar & boost::serialization::base_object<Garbage_Collector_Greedy>(*this);
+    }
+protected:
+	double get_priority(long block_id) const;
+	Block* choose_gc_victim_in_lun(int lun) const;
+};
+
+// Randomized d-choices samples D candidates of a LUN and picks the one with the fewest valid pages,
+// as a controller without an index over its blocks would
+class Garbage_Collector_D_Choices : public Garbage_Collector_Greedy {
+public:
+	Garbage_Collector_D_Choices();
+	Garbage_Collector_D_Choices(Ssd* ssd, Block_manager_parent* bm);
+	static int D;
+	friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+    	ar & boost::serialization::base_object<Garbage_Collector_Greedy>(*this);
+    	ar & candidates; ar & position_in_lun;
     }
+protected:
+	Block* choose_gc_victim_in_lun(int lun) const;
+	void insert(long block_id, int lun, int num_valid_pages);
+	void remove(long block_id, int lun);
 private:
-	vector<long> get_relevant_gc_candidates(int package_id, int die_id, int klass) const;
-	vector<vector<set<long> > > gc_candidates;
+	vector<vector<long> > candidates;	// [lun] -> block IDs, for sampling
+	vector<int> position_in_lun;		// [block ID]
+	mutable MTRand_int32 random_number_generator;	// samples the candidates
 };
 
 class Garbage_Collector_LRU : public Garbage_Collector {
@@ -547,28 +763,64 @@ private:
 	vector<vector<queue<int> > > gc_candidates;  // for each die, a queue of blocks to be erased
 };
 
-class flash_resident_ftl_garbage_collection : public Garbage_Collector {
+// A garbage-collector for FTLs whose mapping table is in flash, such as DFTL. Such an FTL only learns that a page is invalid when
+// the page's old mapping is in its cache, and it notifies the garbage-collector then. Victims are chosen greedily from a counter
+// of valid pages per block, which is small enough for RAM. Which pages of a victim are still valid is kept elsewhere.
+class flash_resident_ftl_garbage_collection : public Garbage_Collector_Greedy {
 public:
-	flash_resident_ftl_garbage_collection(Ssd* ssd, Block_manager_parent* bm) : Garbage_Collector(ssd, bm), ftl(NULL) {}
-	flash_resident_ftl_garbage_collection() : Garbage_Collector(), ftl(NULL) {}
+	flash_resident_ftl_garbage_collection(Ssd* ssd, Block_manager_parent* bm, const char* policy_name) : Garbage_Collector_Greedy(ssd, bm, policy_name), ftl(NULL) {}
+	flash_resident_ftl_garbage_collection() : Garbage_Collector_Greedy(), ftl(NULL) {}
 	virtual void invalid_address_notification(Address const& a, double time) = 0;
-	virtual void set_ftl(flash_resident_page_ftl* new_ftl) { new_ftl = ftl; }
+	virtual void set_ftl(flash_resident_page_ftl* new_ftl) { ftl = new_ftl; }
 protected:
 	flash_resident_page_ftl* ftl;
-
 };
 
+// A bit per page of a block, cleared when the page is invalidated. An entry with the erase flag replaces all older entries of its block.
 struct logarithmic_gecko_index_entry {
+	logarithmic_gecko_index_entry() : bitmap(BLOCK_SIZE, true), erase_flag(false) {}
 	vector<bool> bitmap;
 	bool erase_flag;
 	void print() const;
 };
 
-struct logarithmic_gecko_cached_entry {
-	logarithmic_gecko_cached_entry();
-	vector<bool> bitmap;
-	bool up_to_date;
-	void print() const;
+// Logarithmic Gecko keeps the page-validity bitmaps in flash, as a log-structured merge tree of invalidation records.
+// Records are buffered in RAM, one flash page worth of them at a time. A full buffer is written to flash as a sorted run.
+// Level i holds a single run of at most ENTRIES_PER_PAGE * SIZE_RATIO^(i + 1) entries, and a run that outgrows its level is
+// merged into the next one. Merging reads the runs and writes the merged run. RAM only holds the buffer and the first block ID of
+// each flash page of a run, so that finding the entries of a victim costs at most one flash read per level.
+// The flash pages of the index use logical addresses above the logical address space of the host, as DFTL's translation pages do.
+class Logarithmic_Gecko : public flash_resident_ftl_garbage_collection {
+public:
+	Logarithmic_Gecko();
+	Logarithmic_Gecko(Ssd* ssd, Block_manager_parent* bm);
+	~Logarithmic_Gecko();
+	void invalid_address_notification(Address const& a, double time);
+	void register_event_completion(Event const& event);
+	void commit_choice_of_victim(Address const& phys_address, double time);
+	void set_scheduler(IOScheduler* new_scheduler) { scheduler = new_scheduler; }
+	static int ENTRIES_PER_PAGE;
+	static int SIZE_RATIO;
+private:
+	typedef vector<pair<long, logarithmic_gecko_index_entry> > run;	// sorted by block ID
+	void flush_buffer(double time);
+	run merge(run const& newer, run const& older, bool last_level) const;
+	void write_run(int level, double time);
+	void free_pages(int level);
+	bool read_page(long logical_address, double time);
+	vector<bool> lookup(long block_id, double time);
+	long get_num_pages(run const& r) const { return (r.size() + ENTRIES_PER_PAGE - 1) / ENTRIES_PER_PAGE; }
+	IOScheduler* scheduler;
+	map<long, logarithmic_gecko_index_entry> buffer;
+	vector<run> levels;
+	vector<vector<long> > pages_of_level;	// [level] -> logical addresses of the flash pages holding the run
+	deque<long> free_logical_addresses;
+	long first_logical_address;
+	long next_logical_address;
+	vector<bool> looked_up;					// [block ID] -> whether the entries of a victim have been looked up since its last erase
+	long num_invalidations, num_erase_records, num_flushes, num_merges;
+	long num_flash_writes, num_merge_reads, num_lookups, num_lookup_reads;
+	long num_pages_found_invalid_in_cache;
 };
 
 enum write_amp_choice {greedy, prob, opt};
@@ -682,6 +934,7 @@ public:
 	temperature_detector() : groups_demo(), groups(groups_demo) {}
 	virtual ~temperature_detector() {}
 	virtual int which_group_should_this_page_belong_to(Event const& event) = 0;
+	virtual void register_write_arrival(Event const& event) {}
 	virtual void register_write_completed(Event const& event, int prior_group, int group_id) { }
 	virtual void change_in_groups(vector<group>& groups, double current_time) {}
 	template<class Archive> void serialize(Archive & ar, const unsigned int version)
@@ -724,6 +977,7 @@ public:
 	void check_if_should_trigger_more_GC(Event const&);
 	void try_to_allocate_block_to_group(int group_id, int package, int die, double time);
 	bool may_garbage_collect_this_block(Block* block, double current_time);
+	bool may_copy_back(Address const& page_address) const { return false; } // migrated pages go to the block of their group
 	void register_logical_address(Event const& event, int group_id);
     void print() const;
     void add_group(double starting_prob_val = 0);
@@ -735,6 +989,7 @@ public:
     	ar & detector;
     }
     static int detector_type;
+    static double op_reallocation_period;
     static int reclamation_threshold;
     static bool prioritize_groups_that_need_blocks;
     static int garbage_collection_policy_within_groups; // 0 for LRU, 1 for greedy
@@ -744,7 +999,12 @@ protected:
 private:
 	void give_block_to_group(int package, int die, int group_id, double current_time);
 	void request_gc(int group_id, int package, int die, double time);
+	int get_group_of_block(Address const& address) const;
+	void reallocate_op(double current_time);
 	vector<group> groups;
+	double next_op_reallocation;
+	vector<int> writes_at_last_reallocation;
+	int num_op_reallocations;
 	struct statistics {
 		statistics() : num_group_misses(0),
 				num_starved_gc_operations_requested(0), num_normal_gc_operations_requested(0) {}
@@ -783,7 +1043,7 @@ protected:
 	public:
 		group_data(group const& group_ref, vector<group>& data);
 		group_data();
-		vector<bloom_filter*> filters;
+		vector<blocked_bloom_filter*> filters;
 		int in_filters(Event const& );
 
 		int bloom_filter_hits;
@@ -841,6 +1101,26 @@ public:
 	void adjust_groups(double current_time) {}
 };
 
+// Groups pages by their update frequency, estimated with a count-min sketch of application writes, so its memory does not grow
+// with the logical address space. Group i gets the pages whose frequency, relative to the mean, is in the i-th of num_groups bands.
+// Each band is band_ratio wide and the middle ones are around the mean. The sketch is halved every aging_interval times the
+// logical address space in writes. With this detector, Block_Manager_Groups keeps no group or tag per logical address.
+class sketch_detector : public temperature_detector {
+public:
+	sketch_detector(vector<group>& groups, Block_Manager_Groups* bm);
+	~sketch_detector();
+	int which_group_should_this_page_belong_to(Event const& event);
+	void register_write_arrival(Event const& event);
+	static int num_groups;
+	static int sketch_width;
+	static double band_ratio;
+	static double aging_interval;
+private:
+	count_min_sketch sketch;
+	long writes_until_aging;
+	long num_agings;
+};
+
 
 
 }
@@ -104,7 +104,26 @@ int SCHEDULING_SCHEME = 2;
 bool ENABLE_WEAR_LEVELING = false;
 int WEAR_LEVEL_THRESHOLD = 100;
 int MAX_ONGOING_WL_OPS = 1;
+// Static wear-leveling migrates at most WEAR_LEVELING_PAGES_PER_SECOND pages per second, 0 for no limit. It waits until the LUN
+// of its block has had no application IO for WEAR_LEVELING_IDLE_WINDOW microseconds, 0 to not wait, unless the age spread
+// between the oldest and youngest block has reached WEAR_LEVEL_MAX_SPREAD erases.
+double WEAR_LEVELING_PAGES_PER_SECOND = 0;
+double WEAR_LEVELING_IDLE_WINDOW = 0;
+int WEAR_LEVEL_MAX_SPREAD = 200;
+// Garbage-collection budgets. The number of blocks a LUN or channel may garbage-collect at once grows with how far
+// its LUNs are below GREED_SCALE free blocks, up to these caps, see Migrator::get_lun_budget and get_channel_budget.
+// The defaults keep one operation per LUN and no channel budget. 0 means no channel budget, and no cap on the whole SSD
+// for MAX_CONCURRENT_GC_OPS.
+int MAX_GC_OPS_PER_LUN = 1;
+int MAX_GC_OPS_PER_CHANNEL = 0;
 int MAX_CONCURRENT_GC_OPS = 1;
+// The number of page migrations of a victim block in flight at once. Their writes may go to different LUNs.
+int GC_MIGRATION_PIPELINE_DEPTH = 1;
+
+// Background garbage-collection. Once no application IO has been issued to a LUN for BACKGROUND_GC_IDLE_WINDOW
+// microseconds, the LUN is garbage-collected until it has BACKGROUND_GC_FREE_BLOCKS free blocks. 0 disables it.
+double BACKGROUND_GC_IDLE_WINDOW = 0;
+int BACKGROUND_GC_FREE_BLOCKS = 4;
 
 /*
  * Block manager controls how writes are allocated across the physical architecture of the device
@@ -123,6 +142,9 @@ int BLOCK_MANAGER_ID = 3;
  * The policy used to choose a garbage-collection victim
  * 0 -> Greedy - for each LUN, always picks the block with the least number of pages
  * 1 -> LRU -- for each LUN, always picks the block that was cleaned last
+ * 2 -> Cost-benefit -- for each LUN, picks the block with the highest age * (1 - u) / 2u, where u is the fraction of valid pages
+ * 3 -> D-choices -- for each LUN, samples Garbage_Collector_D_Choices::D blocks and picks the one with the least number of pages
+ * 4 -> Logarithmic Gecko -- greedy, with the page-validity bitmaps kept in flash. Only for DFTL, and greedy for other FTLs.
  */
 int GARBAGE_COLLECTION_POLICY = 0;
 
@@ -144,6 +166,7 @@ int GREED_SCALE = 2;
  * 1 -> DFTL
  * 2 -> FAST
  * 3 -> LSM FTL
+ * 4 -> ZNS (host-managed zones, no device garbage-collection)
  */
 int FTL_DESIGN = 0;
 bool IS_FTL_PAGE_MAPPING = 0;
@@ -171,12 +194,10 @@ bool ALLOW_DEFERRING_TRANSFERS = true;
 double OVER_PROVISIONING_FACTOR = 0.7;
 
 /* Defines the max number of copy back operations on a page before ECC check is performed.
- * Set to zero to disable copy back GC operations */
+ * A garbage-collection migration within a die then skips the channel, unless the page's data has been copied back
+ * this many times since it last went through the controller. Set to zero to disable copy back GC operations */
 uint MAX_REPEATED_COPY_BACKS_ALLOWED = 0;
 
-/* Defines the max number of page addresses in map keeping track of each pages copy back count */
-uint MAX_ITEMS_IN_COPY_BACK_MAP = 1024;
-
 /* Defines the maximal length of the number of outstanding IOs that the OS can submit to the SSD  */
 int MAX_SSD_QUEUE_SIZE = 32;
 
@@ -185,12 +206,42 @@ int WRITE_DEADLINE = 10000000;
 int READ_DEADLINE =  10000000;
 int READ_TRANSFER_DEADLINE = 10000000;
 
-// This is to be ignored for now
+// The page hotness measurer of the block managers that separate hot and cold data, see Page_Hotness_Measurer::get_new_instance
+// 0 -> Bloom filters, 1 -> exact counts per page, 2 -> Count-Min sketch
 int PAGE_HOTNESS_MEASURER = 0;
 
+/* The accuracy of the Count-Min sketch measurer, see Count_Min_Page_Hotness_Measurer
+ * A count overestimates the true count by at most COUNT_MIN_EPSILON times the number of IOs counted, with probability 1 - COUNT_MIN_DELTA.
+ * The counters are halved every COUNT_MIN_DECAY_INTERVAL IOs of their type. 0 means the number of logical pages.
+ * A page is hot if its count is at least COUNT_MIN_HOT_THRESHOLD times the mean count per logical page.
+ */
+double COUNT_MIN_EPSILON = 0.0001;
+double COUNT_MIN_DELTA = 0.01;
+int COUNT_MIN_DECAY_INTERVAL = 0;
+double COUNT_MIN_HOT_THRESHOLD = 2;
+
 // The amount of SRAM available to the FTL in bytes
 int SRAM;
 
+/*
+ * The controller's DRAM write-back cache, see Write_Back_Cache. Its size is in pages, and 0 disables it.
+ * Dirty pages are destaged once they fill more than WRITE_CACHE_HIGH_WATERMARK percent of the cache, until they fill at most
+ * WRITE_CACHE_LOW_WATERMARK percent. If WRITE_CACHE_IDLE_FLUSH is set, they are also destaged whenever no application IOs are outstanding.
+ * At most WRITE_CACHE_DESTAGE_BATCH destage writes are in flight at a time. 0 means one per LUN.
+ */
+int WRITE_CACHE_PAGES = 0;
+int WRITE_CACHE_HIGH_WATERMARK = 90;
+int WRITE_CACHE_LOW_WATERMARK = 70;
+bool WRITE_CACHE_IDLE_FLUSH = true;
+int WRITE_CACHE_DESTAGE_BATCH = 0;
+
+/*
+ * The controller's DRAM read cache, see Read_Cache. Its size is in pages, and 0 disables it.
+ * READ_CACHE_POLICY chooses the eviction policy. 0 is LRU and 1 is ARC.
+ */
+int READ_CACHE_PAGES = 0;
+int READ_CACHE_POLICY = 0;
+
 void load_entry(char *name, double value, uint line_number) {
 	/* cheap implementation - go through all possibilities and match entry */
 	if (!strcmp(name, "BUS_CTRL_DELAY"))
@@ -219,18 +270,38 @@ void load_entry(char *name, double value, uint line_number) {
 		PAGE_SIZE = value;
 	else if (!strcmp(name, "MAX_REPEATED_COPY_BACKS_ALLOWED"))
 		MAX_REPEATED_COPY_BACKS_ALLOWED = value;
-	else if (!strcmp(name, "MAX_ITEMS_IN_COPY_BACK_MAP"))
-		MAX_ITEMS_IN_COPY_BACK_MAP = value;
 	else if (!strcmp(name, "MAX_SSD_QUEUE_SIZE"))
 		MAX_SSD_QUEUE_SIZE = value;
 	else if (!strcmp(name, "OVER_PROVISIONING_FACTOR"))
 		OVER_PROVISIONING_FACTOR = value;
 	else if (!strcmp(name, "BLOCK_MANAGER_ID"))
 		BLOCK_MANAGER_ID = value;
+	else if (!strcmp(name, "GARBAGE_COLLECTION_POLICY"))
+		GARBAGE_COLLECTION_POLICY = value;
 	else if (!strcmp(name, "GREED_SCALE"))
 		GREED_SCALE = value;
+	else if (!strcmp(name, "PAGE_HOTNESS_MEASURER"))
+		PAGE_HOTNESS_MEASURER = value;
+	else if (!strcmp(name, "COUNT_MIN_EPSILON"))
+		COUNT_MIN_EPSILON = value;
+	else if (!strcmp(name, "COUNT_MIN_DELTA"))
+		COUNT_MIN_DELTA = value;
+	else if (!strcmp(name, "COUNT_MIN_DECAY_INTERVAL"))
+		COUNT_MIN_DECAY_INTERVAL = value;
+	else if (!strcmp(name, "COUNT_MIN_HOT_THRESHOLD"))
+		COUNT_MIN_HOT_THRESHOLD = value;
 	else if (!strcmp(name, "MAX_CONCURRENT_GC_OPS"))
 		MAX_CONCURRENT_GC_OPS = value;
+	else if (!strcmp(name, "MAX_GC_OPS_PER_LUN"))
+		MAX_GC_OPS_PER_LUN = value;
+	else if (!strcmp(name, "MAX_GC_OPS_PER_CHANNEL"))
+		MAX_GC_OPS_PER_CHANNEL = value;
+	else if (!strcmp(name, "GC_MIGRATION_PIPELINE_DEPTH"))
+		GC_MIGRATION_PIPELINE_DEPTH = value;
+	else if (!strcmp(name, "BACKGROUND_GC_IDLE_WINDOW"))
+		BACKGROUND_GC_IDLE_WINDOW = value;
+	else if (!strcmp(name, "BACKGROUND_GC_FREE_BLOCKS"))
+		BACKGROUND_GC_FREE_BLOCKS = value;
 	else if (!strcmp(name, "OS_SCHEDULER"))
 		OS_SCHEDULER = value;
 	else if (!strcmp(name, "GREED_SCALE"))
@@ -245,8 +316,28 @@ void load_entry(char *name, double value, uint line_number) {
 		READ_DEADLINE = value;
 	else if (!strcmp(name, "ENABLE_WEAR_LEVELING"))
 		ENABLE_WEAR_LEVELING = value;
+	else if (!strcmp(name, "WEAR_LEVELING_PAGES_PER_SECOND"))
+		WEAR_LEVELING_PAGES_PER_SECOND = value;
+	else if (!strcmp(name, "WEAR_LEVELING_IDLE_WINDOW"))
+		WEAR_LEVELING_IDLE_WINDOW = value;
+	else if (!strcmp(name, "WEAR_LEVEL_MAX_SPREAD"))
+		WEAR_LEVEL_MAX_SPREAD = value;
 	else if (!strcmp(name, "ENABLE_TAGGING"))
 		ENABLE_TAGGING = value;
+	else if (!strcmp(name, "WRITE_CACHE_PAGES"))
+		WRITE_CACHE_PAGES = value;
+	else if (!strcmp(name, "WRITE_CACHE_HIGH_WATERMARK"))
+		WRITE_CACHE_HIGH_WATERMARK = value;
+	else if (!strcmp(name, "WRITE_CACHE_LOW_WATERMARK"))
+		WRITE_CACHE_LOW_WATERMARK = value;
+	else if (!strcmp(name, "WRITE_CACHE_IDLE_FLUSH"))
+		WRITE_CACHE_IDLE_FLUSH = value;
+	else if (!strcmp(name, "WRITE_CACHE_DESTAGE_BATCH"))
+		WRITE_CACHE_DESTAGE_BATCH = value;
+	else if (!strcmp(name, "READ_CACHE_PAGES"))
+		READ_CACHE_PAGES = value;
+	else if (!strcmp(name, "READ_CACHE_POLICY"))
+		READ_CACHE_POLICY = value;
 	else
 		fprintf(stderr, "Config file parsing error on line %u:  %s   %f\n", line_number, name, value);
 	return;
@@ -375,13 +466,33 @@ void print_config(FILE *stream) {
 
 	fprintf(stream, "#Controller:\n");
 	fprintf(stream, "\tBLOCK_MANAGER_ID:\t%u\n", BLOCK_MANAGER_ID);
+	fprintf(stream, "\tGARBAGE_COLLECTION_POLICY:\t%u\n", GARBAGE_COLLECTION_POLICY);
 	fprintf(stream, "\tGREED_SCALE:\t%u\n", GREED_SCALE);
+	fprintf(stream, "\tPAGE_HOTNESS_MEASURER: %i\n", PAGE_HOTNESS_MEASURER);
+	fprintf(stream, "\tCOUNT_MIN_EPSILON:\t%f\n", COUNT_MIN_EPSILON);
+	fprintf(stream, "\tCOUNT_MIN_DELTA:\t%f\n", COUNT_MIN_DELTA);
+	fprintf(stream, "\tCOUNT_MIN_DECAY_INTERVAL: %i\n", COUNT_MIN_DECAY_INTERVAL);
+	fprintf(stream, "\tCOUNT_MIN_HOT_THRESHOLD:\t%f\n", COUNT_MIN_HOT_THRESHOLD);
 	fprintf(stream, "\tMAX_CONCURRENT_GC_OPS:\t%u\n", MAX_CONCURRENT_GC_OPS);
-	fprintf(stream, "\tMAX_REPEATED_COPY_BACKS_ALLOWED: %i\n", MAX_REPEATED_COPY_BACKS_ALLOWED);
-	fprintf(stream, "\tMAX_ITEMS_IN_COPY_BACK_MAP: %i\n\n", MAX_ITEMS_IN_COPY_BACK_MAP);
+	fprintf(stream, "\tMAX_GC_OPS_PER_LUN: %i\n", MAX_GC_OPS_PER_LUN);
+	fprintf(stream, "\tMAX_GC_OPS_PER_CHANNEL: %i\n", MAX_GC_OPS_PER_CHANNEL);
+	fprintf(stream, "\tGC_MIGRATION_PIPELINE_DEPTH: %i\n", GC_MIGRATION_PIPELINE_DEPTH);
+	fprintf(stream, "\tBACKGROUND_GC_IDLE_WINDOW:\t%f\n", BACKGROUND_GC_IDLE_WINDOW);
+	fprintf(stream, "\tBACKGROUND_GC_FREE_BLOCKS:\t%u\n", BACKGROUND_GC_FREE_BLOCKS);
+	fprintf(stream, "\tMAX_REPEATED_COPY_BACKS_ALLOWED: %i\n\n", MAX_REPEATED_COPY_BACKS_ALLOWED);
 	fprintf(stream, "\tWRITE_DEADLINE: %i\n\n", WRITE_DEADLINE);
 	fprintf(stream, "\tREAD_DEADLINE: %i\n\n", READ_DEADLINE);
-	fprintf(stream, "\tENABLE_WEAR_LEVELING: %i\n\n", ENABLE_WEAR_LEVELING);
+	fprintf(stream, "\tENABLE_WEAR_LEVELING: %i\n", ENABLE_WEAR_LEVELING);
+	fprintf(stream, "\tWEAR_LEVELING_PAGES_PER_SECOND:\t%f\n", WEAR_LEVELING_PAGES_PER_SECOND);
+	fprintf(stream, "\tWEAR_LEVELING_IDLE_WINDOW:\t%f\n", WEAR_LEVELING_IDLE_WINDOW);
+	fprintf(stream, "\tWEAR_LEVEL_MAX_SPREAD: %i\n\n", WEAR_LEVEL_MAX_SPREAD);
+	fprintf(stream, "\tWRITE_CACHE_PAGES: %i\n", WRITE_CACHE_PAGES);
+	fprintf(stream, "\tWRITE_CACHE_HIGH_WATERMARK: %i\n", WRITE_CACHE_HIGH_WATERMARK);
+	fprintf(stream, "\tWRITE_CACHE_LOW_WATERMARK: %i\n", WRITE_CACHE_LOW_WATERMARK);
+	fprintf(stream, "\tWRITE_CACHE_IDLE_FLUSH: %i\n", WRITE_CACHE_IDLE_FLUSH);
+	fprintf(stream, "\tWRITE_CACHE_DESTAGE_BATCH: %i\n", WRITE_CACHE_DESTAGE_BATCH);
+	fprintf(stream, "\tREAD_CACHE_PAGES: %i\n", READ_CACHE_PAGES);
+	fprintf(stream, "\tREAD_CACHE_POLICY: %i\n\n", READ_CACHE_POLICY);
 
 	fprintf(stream, "#Open Interface:\n");
 	fprintf(stream, "\tENABLE_TAGGING: %i\n\n", ENABLE_TAGGING);
@@ -25,6 +25,7 @@ Event::Event(enum event_type type, ulong logical_address, uint size, double star
 	application_io_id(application_io_id_generator++),
 	garbage_collection_op(false),
 	wear_leveling_op(false),
+	background_op(false),
 	mapping_op(false),
 	original_application_io(false),
 	age_class(0),
@@ -34,6 +35,9 @@ Event::Event(enum event_type type, ulong logical_address, uint size, double star
 	pure_ssd_wait_time(0),
 	copyback(false),
 	cached_write(false),
+	zone_append(false),
+	force_unit_access(false),
+	flush(false),
 	num_iterations_in_scheduler(0),
 	ssd_id(UNDEFINED)
 {
@@ -64,6 +68,7 @@ Event::Event(Event const& event) :
 	application_io_id(event.application_io_id),
 	garbage_collection_op(event.garbage_collection_op),
 	wear_leveling_op(event.wear_leveling_op),
+	background_op(event.background_op),
 	mapping_op(event.mapping_op),
 	original_application_io(event.original_application_io),
 	age_class(event.age_class),
@@ -73,6 +78,9 @@ Event::Event(Event const& event) :
 	pure_ssd_wait_time(event.pure_ssd_wait_time),
 	copyback(event.copyback),
 	cached_write(event.cached_write),
+	zone_append(event.zone_append),
+	force_unit_access(event.force_unit_access),
+	flush(event.flush),
 	num_iterations_in_scheduler(0),
 	ssd_id(event.ssd_id)
 {}
@@ -140,6 +148,9 @@ void Event::print(FILE *stream) const
 	if (wear_leveling_op) {
 		fprintf(stream, " WL");
 	}
+	if (background_op) {
+		fprintf(stream, " BG");
+	}
 	if (original_application_io) {
 		fprintf(stream, " APP");
 	}
@@ -62,10 +62,6 @@ void Experiment::run(string name) {
 	Thread::set_record_internal_statistics(true);
 	StatisticsGatherer::set_record_statistics(true);
 
-	if (MAX_REPEATED_COPY_BACKS_ALLOWED > 0) {
-		fprintf(stderr, "The simulation parameter MAX_REPEATED_COPY_BACKS_ALLOWED is greater than 0. This is still buggy, and so we fail.\nSet this parameter to 0 to remove this error message.\n");
-	}
-
 	if (i_variable == NULL && d_variable == NULL) {
 		run_single_point(name);
 	}
@@ -324,45 +320,6 @@ Experiment_Result Experiment::copyback_experiment(vector<Thread*> (*experiment)(
 	return experiment_result;
 }
 
-Experiment_Result Experiment::copyback_map_experiment(vector<Thread*> (*experiment)(int highest_lba), int cb_map_min, int cb_map_max, int cb_map_inc, int used_space, string data_folder, string name, int IO_limit) {
-    Experiment_Result experiment_result(name, data_folder, "", "Max copyback map size");
-    experiment_result.start_experiment();
-
-    const int num_pages = NUMBER_OF_ADDRESSABLE_BLOCKS() * BLOCK_SIZE;
-    for (int copyback_map_size = cb_map_min; copyback_map_size <= cb_map_max; copyback_map_size += cb_map_inc) {
-		int highest_lba = (int) ((double) num_pages * used_space / 100);
-		printf("-------------------------------------------------------\n");
-		printf("Experiment with %d copybacks allowed in copyback map.  \n", copyback_map_size);
-		printf("-------------------------------------------------------\n");
-
-		MAX_ITEMS_IN_COPY_BACK_MAP = copyback_map_size;
-
-		// Run experiment
-		vector<Thread*> threads = experiment(highest_lba);
-		OperatingSystem* os = new OperatingSystem();
-		os->set_threads(threads);
-		os->set_num_writes_to_stop_after(IO_limit);
-		os->run();
-
-		stringstream var_str;
-		var_str << copyback_map_size;
-
-		// Collect statistics from this experiment iteration (save in csv files)
-		experiment_result.collect_stats(var_str.str());
-
-		StatisticsGatherer::get_global_instance()->print();
-		if (PRINT_LEVEL >= 1) {
-			StateVisualiser::print_page_status();
-			StateVisualiser::print_block_ages();
-		}
-
-		delete os;
-	}
-
-	experiment_result.end_experiment();
-	return experiment_result;
-}
-
 // currently, this method checks if there if a file already exists, and if so, assumes it is valid.
 // ideally, a check should be made to ensure the saved SSD state matches with the state of the current global parameters
 void Experiment::calibrate_and_save(Workload_Definition* workload, string name, int num_IOs, bool force) {
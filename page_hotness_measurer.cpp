@@ -16,6 +16,14 @@ using namespace ssd;
 //Page_Hotness_Measurer::Page_Hotness_Measurer() {}
 //Page_Hotness_Measurer::~Page_Hotness_Measurer(void) {}
 
+Page_Hotness_Measurer* Page_Hotness_Measurer::get_new_instance() {
+	switch (PAGE_HOTNESS_MEASURER) {
+		case 1: return new Simple_Page_Hotness_Measurer();
+		case 2: return new Count_Min_Page_Hotness_Measurer();
+		default: return new BloomFilter_Page_Hotness_Measurer();
+	}
+}
+
 /*
  * Simple hotness measurer
  * ----------------------------------------------------------------------------------
@@ -244,11 +252,11 @@ BloomFilter_Page_Hotness_Measurer::BloomFilter_Page_Hotness_Measurer(uint num_bl
 	if (!parameters) std::cout << "Error - Invalid set of bloom filter parameters!" << std::endl;
 
 	if (PRINT_LEVEL >= 1) printf("Chosen false positive probability: %f\nChosen projected element count: %llu\n", parameters.false_positive_probability, parameters.projected_element_count);
-	parameters.compute_optimal_parameters();
-	if (PRINT_LEVEL >= 1) printf("bloom_filter optimal parameters:\nNumber of hashes: %d\nTable size: %llu bits (%llu bytes)\n", parameters.optimal_parameters.number_of_hashes, parameters.optimal_parameters.table_size, parameters.optimal_parameters.table_size / 8);
+	blocked_bloom_filter prototype(parameters);
+	if (PRINT_LEVEL >= 1) printf("bloom_filter parameters:\nNumber of hashes: %d\nTable size: %lu bits (%lu bytes)\n", prototype.get_num_hashes(), prototype.size(), prototype.size() / 8);
 
-	read_bloom.resize(num_bloom_filters, bloom_filter(parameters));
-	write_bloom.resize(num_bloom_filters, bloom_filter(parameters));
+	read_bloom.resize(num_bloom_filters, prototype);
+	write_bloom.resize(num_bloom_filters, prototype);
 
 	// Initialize 2D vector package_die_stats indexed by [package][die], used for keeping track of LUN usage statistics
 	package_die_stats.resize(SSD_SIZE);
@@ -348,10 +356,11 @@ void BloomFilter_Page_Hotness_Measurer::register_event(Event const& event) {
 		}
 
 		// Find a filter where address is not present (if any), starting from newest, and insert
+		blocked_bloom_filter::probe probe = filter[0].get_probe(page_address); // All filters have the same size, so the key is hashed once
 		do {
 			pos = (pos + num_bloom_filters - 1) % num_bloom_filters; // Move backwards from newest to oldest in a round-robin fashion
-			if (filter[pos].contains(page_address)) continue; // Address already in this filter, try next
-			filter[pos].insert(page_address); // Address not in filter, insert and stop
+			if (filter[pos].contains(probe)) continue; // Address already in this filter, try next
+			filter[pos].insert(probe); // Address not in filter, insert and stop
 			break;
 		} while (pos != startPos);
 
@@ -424,11 +433,12 @@ double BloomFilter_Page_Hotness_Measurer::get_hot_data_index(event_type type, ul
 
 	uint pos = oldest_BF;
 	uint newness = 0;
+	blocked_bloom_filter::probe probe = filter[0].get_probe(page_address);
 
 	// Iterate though BFs from oldest to newest, adding recency weight to result if address in BF
 	do {
 		newness++;
-		if (filter[pos].contains(page_address)) result += (newness * stepSize);
+		if (filter[pos].contains(probe)) result += (newness * stepSize);
 		pos = (pos + 1) % num_bloom_filters;
 	} while (pos != oldest_BF);
 
@@ -443,3 +453,77 @@ void BloomFilter_Page_Hotness_Measurer::heat_all_addresses() {
 	}
 }
 
+/* ==================================================================================
+ * Count-Min sketch based hotness measurer
+ * ================================================================================== */
+
+// The width is e / COUNT_MIN_EPSILON, and the depth is ln(1 / COUNT_MIN_DELTA)
+Count_Min_Page_Hotness_Measurer::Count_Min_Page_Hotness_Measurer()
+	:	writes(ceil(exp(1.0) / COUNT_MIN_EPSILON), ceil(log(1 / COUNT_MIN_DELTA))),
+		reads(ceil(exp(1.0) / COUNT_MIN_EPSILON), ceil(log(1 / COUNT_MIN_DELTA))),
+		writes_since_decay(0),
+		reads_since_decay(0),
+		decay_interval(COUNT_MIN_DECAY_INTERVAL > 0 ? COUNT_MIN_DECAY_INTERVAL : NUMBER_OF_ADDRESSABLE_PAGES()),
+		writes_per_die(SSD_SIZE, vector<double>(PACKAGE_SIZE, 0)),
+		reads_per_die(SSD_SIZE, vector<double>(PACKAGE_SIZE, 0))
+{}
+
+enum write_hotness Count_Min_Page_Hotness_Measurer::get_write_hotness(ulong page_address) const {
+	return is_hot(writes, page_address) ? WRITE_HOT : WRITE_COLD;
+}
+
+enum read_hotness Count_Min_Page_Hotness_Measurer::get_read_hotness(ulong page_address) const {
+	return is_hot(reads, page_address) ? READ_HOT : READ_COLD;
+}
+
+// Among the LUNs with at most the average number of writes, pick the one with the fewest reads for WCRH data and the most for WCRC data
+Address Count_Min_Page_Hotness_Measurer::get_best_target_die_for_WC(enum read_hotness rh) const {
+	double average_writes = 0;
+	for (uint i = 0; i < SSD_SIZE; i++) {
+		for (uint j = 0; j < PACKAGE_SIZE; j++) {
+			average_writes += writes_per_die[i][j];
+		}
+	}
+	average_writes /= SSD_SIZE * PACKAGE_SIZE;
+	int package = UNDEFINED, die = UNDEFINED;
+	double best = rh == READ_HOT ? numeric_limits<double>::max() : -numeric_limits<double>::max();
+	for (uint i = 0; i < SSD_SIZE; i++) {
+		for (uint j = 0; j < PACKAGE_SIZE; j++) {
+			double reads = reads_per_die[i][j];
+			if (writes_per_die[i][j] <= average_writes && ((rh == READ_HOT && reads < best) || (rh == READ_COLD && reads > best))) {
+				best = reads;
+				package = i;
+				die = j;
+			}
+		}
+	}
+	return Address(package, die, 0,0,0, DIE);
+}
+
+void Count_Min_Page_Hotness_Measurer::register_event(Event const& event) {
+	enum event_type type = event.get_event_type();
+	assert(type == WRITE || type == READ_COMMAND);
+	Address phys_addr = event.get_address();
+	vector<vector<double> >& per_die = type == WRITE ? writes_per_die : reads_per_die;
+	count_min_sketch& s = type == WRITE ? writes : reads;
+	int& ios_since_decay = type == WRITE ? writes_since_decay : reads_since_decay;
+	per_die[phys_addr.package][phys_addr.die]++;
+	if (event.is_original_application_io()) {
+		s.add(event.get_logical_address());
+	}
+	if (++ios_since_decay < decay_interval) {
+		return;
+	}
+	ios_since_decay = 0;
+	s.halve();
+	for (auto& package : per_die) {
+		for (auto& die : package) {
+			die /= 2;
+		}
+	}
+}
+
+bool Count_Min_Page_Hotness_Measurer::is_hot(count_min_sketch const& s, ulong page_address) const {
+	uint count = s.estimate(page_address);
+	return count > 0 && count >= COUNT_MIN_HOT_THRESHOLD * s.get_total() / NUMBER_OF_ADDRESSABLE_PAGES();
+}
@@ -0,0 +1,175 @@
+/*
+ * read_cache.cpp
+ *
+ * The controller's DRAM read cache. Pages read from flash are kept in DRAM and evicted with LRU or ARC.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "ssd.h"
+
+using namespace ssd;
+
+Read_Cache::Read_Cache(IOScheduler* scheduler)
+:	scheduler(scheduler),
+	lists(),
+	locations(),
+	target_t1_size(0),
+	misses_in_flight(),
+	reads_in_flight(),
+	num_reads(0),
+	num_hits(0),
+	num_insertions(0),
+	num_invalidations(0),
+	num_evictions(0)
+{}
+
+Read_Cache::~Read_Cache() {
+	if (!is_enabled()) {
+		return;
+	}
+	printf("read cache reads\t%ld\n", num_reads);
+	printf("read cache hits\t%ld\n", num_hits);
+	printf("read cache hit rate\t%f\n", num_reads == 0 ? 0.0 : num_hits / (double)num_reads);
+	printf("read cache insertions\t%ld\n", num_insertions);
+	printf("read cache invalidations\t%ld\n", num_invalidations);
+	printf("read cache evictions\t%ld\n", num_evictions);
+}
+
+// Returns true if the read hit the cache. A missing read goes to the FTL, and its page is inserted once it completes.
+bool Read_Cache::submit(Event* event) {
+	if (!is_enabled() || event->get_event_type() != READ) {
+		return false;
+	}
+	num_reads++;
+	long lba = event->get_logical_address();
+	auto it = locations.find(lba);
+	if (it == locations.end() || (it->second.which != T1 && it->second.which != T2)) {
+		misses_in_flight[event->get_application_io_id()] = lba;
+		reads_in_flight[lba].count++;
+		return false;
+	}
+	num_hits++;
+	move_to(lba, READ_CACHE_POLICY == 1 ? T2 : T1);
+	event->set_noop(true);
+	event->incr_execution_time(RAM_READ_DELAY + BUS_DATA_DELAY);
+	scheduler->schedule_event(event);
+	return true;
+}
+
+void Read_Cache::invalidate(long lba) {
+	if (!is_enabled()) {
+		return;
+	}
+	auto r = reads_in_flight.find(lba);
+	if (r != reads_in_flight.end()) {
+		r->second.stale = true;
+	}
+	auto it = locations.find(lba);
+	if (it != locations.end() && (it->second.which == T1 || it->second.which == T2)) {
+		num_invalidations++;
+		remove(lba);
+	}
+}
+
+void Read_Cache::register_event_completion(Event const& event) {
+	if (!is_enabled() || !event.is_original_application_io()) {
+		return;
+	}
+	auto it = misses_in_flight.find(event.get_application_io_id());
+	if (it == misses_in_flight.end() || (event.get_event_type() != READ_TRANSFER && event.get_event_type() != READ)) {
+		return;
+	}
+	long lba = it->second;
+	misses_in_flight.erase(it);
+	read_in_flight& r = reads_in_flight[lba];
+	// a read that did not reach flash, e.g. of an unwritten page, completes as a READ and brings no data
+	if (!r.stale && event.get_event_type() == READ_TRANSFER) {
+		insert(lba);
+	}
+	if (--r.count == 0) {
+		reads_in_flight.erase(lba);
+	}
+}
+
+void Read_Cache::insert(long lba) {
+	long c = READ_CACHE_PAGES;
+	auto it = locations.find(lba);
+	int which = it == locations.end() ? UNDEFINED : it->second.which;
+	if (which == T1 || which == T2) {
+		move_to(lba, READ_CACHE_POLICY == 1 ? T2 : T1);
+		return;
+	}
+	num_insertions++;
+	if (READ_CACHE_POLICY != 1) {
+		if (cached() >= c) {
+			remove(lists[T1].back());
+			num_evictions++;
+		}
+		move_to(lba, T1);
+		return;
+	}
+
+	// ARC grows the target for T1 on a hit in B1, and shrinks it on a hit in B2
+	long b1 = lists[B1].size(), b2 = lists[B2].size();
+	if (which == B1) {
+		target_t1_size = min(c, target_t1_size + max(b2 / b1, 1L));
+		replace(false);
+		move_to(lba, T2);
+		return;
+	}
+	if (which == B2) {
+		target_t1_size = max(0L, target_t1_size - max(b1 / b2, 1L));
+		replace(true);
+		move_to(lba, T2);
+		return;
+	}
+	long l1 = lists[T1].size() + b1;
+	if (l1 >= c) {
+		if ((long)lists[T1].size() < c) {
+			remove(lists[B1].back());
+			replace(false);
+		} else {
+			remove(lists[T1].back());
+			num_evictions++;
+		}
+	} else if (l1 + lists[T2].size() + b2 >= c) {
+		if (l1 + lists[T2].size() + b2 >= 2 * c) {
+			remove(lists[B2].back());
+		}
+		replace(false);
+	}
+	move_to(lba, T1);
+}
+
+void Read_Cache::move_to(long lba, int to) {
+	auto it = locations.find(lba);
+	if (it != locations.end()) {
+		lists[it->second.which].erase(it->second.position);
+	}
+	lists[to].push_front(lba);
+	location& l = locations[lba];
+	l.which = to;
+	l.position = lists[to].begin();
+}
+
+void Read_Cache::remove(long lba) {
+	auto it = locations.find(lba);
+	assert(it != locations.end());
+	lists[it->second.which].erase(it->second.position);
+	locations.erase(it);
+}
+
+// Evicts a page from T1 or T2 into its ghost list. Invalidations may have left space in the cache, and then nothing is evicted.
+void Read_Cache::replace(bool in_b2) {
+	if (cached() < READ_CACHE_PAGES) {
+		return;
+	}
+	long t1 = lists[T1].size();
+	if (t1 > 0 && (t1 > target_t1_size || (in_b2 && t1 == target_t1_size) || lists[T2].empty())) {
+		move_to(lists[T1].back(), B1);
+	} else {
+		move_to(lists[T2].back(), B2);
+	}
+	num_evictions++;
+}
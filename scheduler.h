@@ -151,6 +151,7 @@ public:
 	void handle(Event* event);
 	void handle_noop_events(vector<Event*>& events);
 	void inform_FTL_of_noop_completion(Event* event);
+	void resume_migrations(Address const& page_address, double time);
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
@@ -12,41 +12,47 @@ using namespace std;
 
 #define LIFE_TIME 400 // the number of sequential writes before we recognize the pattern as sequential
 
+int Sequential_Pattern_Detector::STREAM_TABLE_SIZE = 4096;
+int Sequential_Pattern_Detector::MAX_IDLE_IOS = 200;
+
 Sequential_Pattern_Detector::Sequential_Pattern_Detector(uint threshold)
 : sequential_writes_key_lookup(),
-  registration_counter(0),
-  listener(NULL),
   sequential_writes_identification_and_data(),
+  streams(STREAM_TABLE_SIZE, sequential_writes_tracking(0, UNDEFINED)),
+  lru_prev(STREAM_TABLE_SIZE, UNDEFINED),
+  lru_next(STREAM_TABLE_SIZE, UNDEFINED),
+  lru_head(UNDEFINED),
+  lru_tail(UNDEFINED),
+  free_slots(),
+  listener(NULL),
   threshold(threshold),
-  io_num(0) {}
-
-Sequential_Pattern_Detector::~Sequential_Pattern_Detector() {
-	map<logical_address, sequential_writes_tracking*>::iterator i = sequential_writes_identification_and_data.begin();
-	for (; i != sequential_writes_identification_and_data.end(); i++) {
-		sequential_writes_tracking* s = (*i).second;
-		if (s != NULL) {
-			delete s;
-		}
+  io_num(0)
+{
+	assert(STREAM_TABLE_SIZE > 0);
+	sequential_writes_key_lookup.reserve(STREAM_TABLE_SIZE);
+	sequential_writes_identification_and_data.reserve(STREAM_TABLE_SIZE);
+	for (int i = STREAM_TABLE_SIZE - 1; i >= 0; i--) {
+		free_slots.push_back(i);
 	}
-	sequential_writes_identification_and_data.clear();
 }
 
+Sequential_Pattern_Detector::~Sequential_Pattern_Detector() {}
+
 sequential_writes_tracking const& Sequential_Pattern_Detector::register_event(logical_address lb, double time) {
 	//printf("lb=%ld  \tt=%f\tA=%d\tB=%d\n", lb, time, sequential_writes_identification_and_data.count(lb), sequential_writes_key_lookup.count(lb));
 	sequential_writes_tracking * swt;
-	if (sequential_writes_identification_and_data.count(lb) == 1) {
-		swt = restart_pattern(lb, time);
+	unordered_map<logical_address, int>::iterator it;
+	if ((it = sequential_writes_identification_and_data.find(lb)) != sequential_writes_identification_and_data.end()) {
+		swt = restart_pattern((*it).second, time);
 	}
-	else if (sequential_writes_key_lookup.count(lb) == 1) {
-		swt =process_next_write(lb, time);
+	else if ((it = sequential_writes_key_lookup.find(lb)) != sequential_writes_key_lookup.end()) {
+		swt = process_next_write(lb, (*it).second, time);
 	}
 	else {
 		swt = init_pattern(lb, time);
 	}
 
-	if (++registration_counter % 50 == 0) {
-		remove_old_sequential_writes_metadata(time);
-	}
+	remove_old_sequential_writes_metadata(time);
 	io_num++;
 	return *swt;
 }
@@ -55,39 +61,48 @@ sequential_writes_tracking* Sequential_Pattern_Detector::init_pattern(int key, d
 	if (PRINT_LEVEL > 1) {
 		printf("init_pattern: %d \n", key);
 	}
-	sequential_writes_key_lookup[key + 1] = key;
-	sequential_writes_tracking* swt = new sequential_writes_tracking(time, key);
-	swt->last_io_num = io_num;
-	sequential_writes_identification_and_data[key] = swt;
-	return swt;
+	if (free_slots.empty()) {
+		remove_pattern(lru_tail, time);
+	}
+	int slot = free_slots.back();
+	free_slots.pop_back();
+	sequential_writes_tracking& swt = streams[slot] = sequential_writes_tracking(time, key);
+	swt.last_io_num = io_num;
+	sequential_writes_key_lookup[key + 1] = slot;
+	sequential_writes_identification_and_data[key] = slot;
+	move_to_front(slot);
+	return &swt;
 }
 
-sequential_writes_tracking* Sequential_Pattern_Detector::process_next_write(int lb, double time) {
-	int key = sequential_writes_key_lookup[lb];
-	sequential_writes_tracking* swm = sequential_writes_identification_and_data[key];
+sequential_writes_tracking* Sequential_Pattern_Detector::process_next_write(int lb, int slot, double time) {
+	sequential_writes_tracking* swm = &streams[slot];
 	swm->counter++;
 	swm->last_arrival_timestamp = time;
 	swm->last_io_num = io_num;
 	sequential_writes_key_lookup.erase(lb);
-	sequential_writes_key_lookup[lb + 1] = key;
+	sequential_writes_key_lookup[lb + 1] = slot;
+	move_to_front(slot);
 	return swm;
 }
 
-sequential_writes_tracking * Sequential_Pattern_Detector::restart_pattern(int key, double time) {
-	assert(sequential_writes_identification_and_data.count(key) == 1);
-	sequential_writes_tracking* swm = sequential_writes_identification_and_data[key];
+sequential_writes_tracking * Sequential_Pattern_Detector::restart_pattern(int slot, double time) {
+	sequential_writes_tracking* swm = &streams[slot];
 	if (swm->counter < threshold) {
 		return swm;
 	}
 	assert(swm->counter != 0);
 	swm->num_times_pattern_has_repeated++;
-	sequential_writes_key_lookup.erase(key + swm->counter);
-	sequential_writes_key_lookup[key + 1] = key;
+	unordered_map<logical_address, int>::iterator next = sequential_writes_key_lookup.find(swm->key + swm->counter);
+	if (next != sequential_writes_key_lookup.end() && (*next).second == slot) {
+		sequential_writes_key_lookup.erase(next);
+	}
+	sequential_writes_key_lookup[swm->key + 1] = slot;
 	swm->counter = 1;
 	swm->last_arrival_timestamp = time;
 	swm->last_io_num = io_num;
+	move_to_front(slot);
 	if (PRINT_LEVEL > 0) {
-		printf("SEQUENTIAL PATTERN RESTARTED!  key: %d\n", key);
+		printf("SEQUENTIAL PATTERN RESTARTED!  key: %ld\n", swm->key);
 	}
 	return swm;
 }
@@ -96,30 +111,62 @@ void Sequential_Pattern_Detector::set_listener(Sequential_Pattern_Detector_Liste
 	listener = new_listener;
 }
 
-// TODO: invoke this method from somewhere
+// Streams are linked in the order they were last written, so the idle ones are all at the tail
 void Sequential_Pattern_Detector::remove_old_sequential_writes_metadata(double time) {
-	map<logical_address, sequential_writes_tracking*>::iterator iter = sequential_writes_identification_and_data.begin();
-	while(iter != sequential_writes_identification_and_data.end())
-	{
-		logical_address key = (*iter).first;
-		if ((*iter).second->last_io_num + 200 < io_num) {
-			if (PRINT_LEVEL > 1) {
-				printf("deleting seq write with key %d:\n", key);
-			}
-			uint next_expected_lba = (*iter).second->counter + key;
-			sequential_writes_key_lookup.erase(next_expected_lba);
-			delete (*iter).second;
-			sequential_writes_identification_and_data.erase(iter++);
-			//sequential_writes_identification_and_data.erase(iter);
-			if (listener != NULL) {
-				listener->sequential_event_metadata_removed(key, time);
-			}
-			assert(sequential_writes_identification_and_data.count(key) == 0);
-			//++iter;
-		} else {
-			++iter;
-		}
+	while (lru_tail != UNDEFINED && streams[lru_tail].last_io_num + MAX_IDLE_IOS < io_num) {
+		remove_pattern(lru_tail, time);
+	}
+}
+
+void Sequential_Pattern_Detector::remove_pattern(int slot, double time) {
+	sequential_writes_tracking const& swt = streams[slot];
+	long key = swt.key;
+	if (PRINT_LEVEL > 1) {
+		printf("deleting seq write with key %ld:\n", key);
+	}
+	// another stream may since have claimed the next LBA this one expects
+	unordered_map<logical_address, int>::iterator next = sequential_writes_key_lookup.find(key + swt.counter);
+	if (next != sequential_writes_key_lookup.end() && (*next).second == slot) {
+		sequential_writes_key_lookup.erase(next);
+	}
+	sequential_writes_identification_and_data.erase(key);
+	unlink(slot);
+	free_slots.push_back(slot);
+	if (listener != NULL) {
+		listener->sequential_event_metadata_removed(key, time);
+	}
+}
+
+void Sequential_Pattern_Detector::move_to_front(int slot) {
+	if (lru_head == slot) {
+		return;
+	}
+	if (lru_prev[slot] != UNDEFINED) {
+		unlink(slot);
+	}
+	lru_prev[slot] = UNDEFINED;
+	lru_next[slot] = lru_head;
+	if (lru_head != UNDEFINED) {
+		lru_prev[lru_head] = slot;
+	}
+	lru_head = slot;
+	if (lru_tail == UNDEFINED) {
+		lru_tail = slot;
+	}
+}
+
+void Sequential_Pattern_Detector::unlink(int slot) {
+	if (lru_prev[slot] != UNDEFINED) {
+		lru_next[lru_prev[slot]] = lru_next[slot];
+	} else {
+		lru_head = lru_next[slot];
+	}
+	if (lru_next[slot] != UNDEFINED) {
+		lru_prev[lru_next[slot]] = lru_prev[slot];
+	} else {
+		lru_tail = lru_prev[slot];
 	}
+	lru_prev[slot] = lru_next[slot] = UNDEFINED;
 }
 
 sequential_writes_tracking::sequential_writes_tracking(double time, long key)
@@ -18,7 +18,9 @@ Ssd::Ssd():
 	last_io_submission_time(0.0),
 	os(NULL),
 	large_events_map(),
-	ftl(NULL)
+	ftl(NULL),
+	write_cache(NULL),
+	read_cache(NULL)
 {
 	for(uint i = 0; i < SSD_SIZE; i++) {
 		int a = PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE * BLOCK_SIZE * i;
@@ -38,11 +40,14 @@ Ssd::Ssd():
 		case 0: ftl = new FtlImpl_Page(this, bm); break;
 		case 1: ftl = new DFTL(this, bm); break;
 		case 2: ftl = new FAST(this, bm, migrator); break;
+		case 4: ftl = new ZNS(this, bm, migrator); break;
 		default: ftl = new FtlImpl_Page(this, bm); break;
 		}
 	}
 
 	scheduler = new IOScheduler();
+	write_cache = new Write_Back_Cache(ftl, scheduler);
+	read_cache = new Read_Cache(scheduler);
 
 	Free_Space_Meter::init();
 	Free_Space_Per_LUN_Meter::init();
@@ -51,6 +56,9 @@ Ssd::Ssd():
 		switch (GARBAGE_COLLECTION_POLICY) {
 		case 0: gc = new Garbage_Collector_Greedy(this, bm); break;
 		case 1: gc = new Garbage_Collector_LRU(this, bm); break;
+		case 2: gc = new Garbage_Collector_Cost_Benefit(this, bm); break;
+		case 3: gc = new Garbage_Collector_D_Choices(this, bm); break;
+		case 4: gc = FTL_DESIGN == 1 ? (Garbage_Collector*)new Logarithmic_Gecko(this, bm) : new Garbage_Collector_Greedy(this, bm); break;
 		default: gc = new Garbage_Collector_Greedy(this, bm); break;
 		}
 	}
@@ -58,6 +66,13 @@ Ssd::Ssd():
 	ftl->set_scheduler(scheduler);
 	gc->set_scheduler(scheduler);
 
+	flash_resident_ftl_garbage_collection* flash_resident_gc = dynamic_cast<flash_resident_ftl_garbage_collection*>(gc);
+	if (flash_resident_gc != NULL) {
+		flash_resident_page_ftl* flash_resident_ftl = dynamic_cast<flash_resident_page_ftl*>(ftl);
+		flash_resident_ftl->set_gc(flash_resident_gc);
+		flash_resident_gc->set_ftl(flash_resident_ftl);
+	}
+
 	Wear_Leveling_Strategy* wl = new Wear_Leveling_Strategy(this, migrator);
 
 	bm->init(this, ftl, scheduler, gc, wl, migrator);
@@ -74,6 +89,8 @@ Ssd::Ssd():
 Ssd::~Ssd()
 {
 	execute_all_remaining_events();
+	delete write_cache;
+	delete read_cache;
 	delete ftl;
 	delete scheduler;
 }
@@ -84,6 +101,14 @@ void Ssd::execute_all_remaining_events() {
 	}
 }
 
+// Called once the workload is over, so that the statistics include the destaging of the write cache
+void Ssd::drain_write_cache(double time) {
+	write_cache->drain(time);
+	while (!write_cache->is_drained() && !scheduler->is_empty()) {
+		scheduler->execute_soonest_events();
+	}
+}
+
 void Ssd::submit(Event* event) {
 	if (event->get_ssd_submission_time() + 0.00001 < last_io_submission_time) {
 		fprintf(stderr, "Error: Submission time of event (%f) less than last IO submission time (%f).\n", event->get_ssd_submission_time(), last_io_submission_time);
@@ -116,6 +141,12 @@ void Ssd::submit(Event* event) {
 }
 
 void Ssd::submit_to_ftl(Event* event) {
+	if (event->get_event_type() == WRITE || event->get_event_type() == TRIM) {
+		read_cache->invalidate(event->get_logical_address());
+	}
+	if (write_cache->submit(event) || read_cache->submit(event)) {
+		return;
+	}
 	if(event->get_event_type() 		== READ) 		ftl->read(event);
 	else if(event->get_event_type() == WRITE) 		ftl->write(event);
 	else if(event->get_event_type() == TRIM) 		ftl->trim(event);
@@ -153,6 +184,12 @@ void Ssd::progress_since_os_is_waiting() {
 }
 
 void Ssd::register_event_completion(Event * event) {
+	// destage writes of the write cache are internal to the SSD
+	if (write_cache->register_event_completion(event)) {
+		delete event;
+		return;
+	}
+	read_cache->register_event_completion(*event);
 	if (event->is_original_application_io() && !event->get_noop() && !event->is_cached_write() && (event->get_event_type() == WRITE || event->get_event_type() == READ_TRANSFER)) {
 		last_io_submission_time = max(last_io_submission_time, event->get_ssd_submission_time());
 	}
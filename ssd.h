@@ -8,10 +8,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
 #include <vector>
 #include <stack>
 #include <queue>
 #include <deque>
+#include <list>
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
@@ -183,6 +185,15 @@ extern bool IS_FTL_PAGE_MAPPING;
 
 extern int SRAM;
 
+extern int WRITE_CACHE_PAGES;
+extern int WRITE_CACHE_HIGH_WATERMARK;
+extern int WRITE_CACHE_LOW_WATERMARK;
+extern bool WRITE_CACHE_IDLE_FLUSH;
+extern int WRITE_CACHE_DESTAGE_BATCH;
+
+extern int READ_CACHE_PAGES;
+extern int READ_CACHE_POLICY;
+
 /*
  * Controls the level of detail of output
  */
@@ -193,9 +204,6 @@ extern bool PRINT_FILE_MANAGER_INFO;
  * Set to zero to disable copy back GC operations */
 extern uint MAX_REPEATED_COPY_BACKS_ALLOWED;
 
-/* Defines the max number of page addresses in map keeping track of each pages copy back count */
-extern uint MAX_ITEMS_IN_COPY_BACK_MAP;
-
 /* Defines the maximal length of the SSD queue  */
 extern int MAX_SSD_QUEUE_SIZE;
 
@@ -210,9 +218,21 @@ extern bool BALANCEING_SCHEME;
 extern bool ENABLE_WEAR_LEVELING;
 extern int WEAR_LEVEL_THRESHOLD;
 extern int MAX_ONGOING_WL_OPS;
+extern double WEAR_LEVELING_PAGES_PER_SECOND;
+extern double WEAR_LEVELING_IDLE_WINDOW;
+extern int WEAR_LEVEL_MAX_SPREAD;
 extern int MAX_CONCURRENT_GC_OPS;
+extern int MAX_GC_OPS_PER_LUN;
+extern int MAX_GC_OPS_PER_CHANNEL;
+extern int GC_MIGRATION_PIPELINE_DEPTH;
+extern double BACKGROUND_GC_IDLE_WINDOW;
+extern int BACKGROUND_GC_FREE_BLOCKS;
 
 extern int PAGE_HOTNESS_MEASURER;
+extern double COUNT_MIN_EPSILON;
+extern double COUNT_MIN_DELTA;
+extern int COUNT_MIN_DECAY_INTERVAL;
+extern double COUNT_MIN_HOT_THRESHOLD;
 
 /* Enumerations to clarify status integers in simulation
  * Do not use typedefs on enums for reader clarity */
@@ -283,7 +303,9 @@ class Package;
 class FtlParent;
 class FtlImpl_Page;
 class DFTL;
+class flash_resident_page_ftl;
 class FAST;
+class ZNS;
 class Ssd;
 
 class event_queue;
@@ -303,6 +325,8 @@ class Migrator;
 class Sequential_Pattern_Detector;
 class Page_Hotness_Measurer;
 class Random_Order_Iterator;
+class Random_Permutation;
+class Tournament_Tree;
 
 class OperatingSystem;
 class Thread;
@@ -437,6 +461,12 @@ public:
 	inline void set_copyback(bool value)					{ copyback = value; }
 	inline void set_cached_write(bool value)				{ cached_write = value; }
 	inline bool is_cached_write()							{ return cached_write; }
+	inline void set_zone_append(bool value)					{ zone_append = value; }
+	inline bool is_zone_append() const						{ return zone_append; }
+	inline void set_force_unit_access(bool value)			{ force_unit_access = value; }
+	inline bool is_force_unit_access() const				{ return force_unit_access; }
+	inline void set_flush(bool value)						{ flush = value; }
+	inline bool is_flush() const							{ return flush; }
 	inline int get_age_class() const 						{ return age_class; }
 	inline bool is_garbage_collection_op() const 			{ return garbage_collection_op; }
 	inline bool is_mapping_op() const 						{ return mapping_op; }
@@ -451,6 +481,8 @@ public:
 	inline double get_latency() const 				{ return pure_ssd_wait_time; }
 	inline bool is_wear_leveling_op() const { return wear_leveling_op ; }
 	inline void set_wear_leveling_op(bool value) { wear_leveling_op = value; }
+	inline bool is_background_op() const { return background_op; }
+	inline void set_background_op(bool value) { background_op = value; }
 	void print(FILE *stream = stdout) const;
 	static void reset_id_generators();
 	bool is_flexible_read();
@@ -475,10 +507,14 @@ protected:
 
 	bool garbage_collection_op;
 	bool wear_leveling_op;
+	bool background_op;		// garbage-collection done while the LUN is idle, see Migrator::register_die_activity
 	bool mapping_op;
 	bool original_application_io;
 	bool copyback;
 	bool cached_write;
+	bool zone_append;		// the device chooses the address within the zone, see ZNS
+	bool force_unit_access;	// the write must reach flash before it completes, so it bypasses the write cache
+	bool flush;				// completes once everything in the write cache at its arrival has reached flash
 
 	// an ID for a single IO to the chip. This is not actually used for any logical purpose
 	static uint id_generator;
@@ -658,6 +694,7 @@ public:
 	virtual enum write_hotness get_write_hotness(unsigned long page_address) const = 0; // Return write hotness of a given page address
 	virtual enum read_hotness get_read_hotness(unsigned long page_address) const = 0; // Return read hotness of a given page address
 	virtual Address get_best_target_die_for_WC(enum read_hotness rh) const = 0; // Return address of die with leads WC data (with chosen read hotness)
+	static Page_Hotness_Measurer* get_new_instance();
 };
 
 class Ignorant_Hotness_Measurer : public Page_Hotness_Measurer {
@@ -701,8 +738,88 @@ private:
 };
 
 
+// A Bloom filter in which all bits of a key fall in one 64-byte block, so a lookup touches a single cache line.
+// A multiplicative hash of the key picks the block, and a second one is cut into the bit positions within it.
+// The bits are gathered into a probe, which can be tested against several filters of the same size with one hash.
+// Testing a probe is a branch-free and over the eight words of a block, which compilers turn into vector instructions.
+class blocked_bloom_filter {
+public:
+	struct probe {
+		ulong block;
+		ulong mask[8];
+	};
+	blocked_bloom_filter(bloom_parameters const& parameters = bloom_parameters());
+	// The high bits of a multiplicative hash are the well-mixed ones, so the block comes from the top 32 bits of the first hash
+	// and the bit positions are taken 9 bits at a time from the top of the second, which is rehashed after 7 positions.
+	inline probe get_probe(ulong key) const {
+		probe p = {0, {0, 0, 0, 0, 0, 0, 0, 0}};
+		ulong h = (key + 1) * 0x9E3779B97F4A7C15UL;
+		p.block = ((h >> 32) * num_blocks) >> 32;
+		ulong positions = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9UL;
+		for (int i = 0, j = 0; i < num_hashes; i++, j++) {
+			if (j == 7) {
+				positions = (positions ^ (positions >> 31)) * 0x94D049BB133111EBUL;
+				j = 0;
+			}
+			uint bit = (positions >> (55 - 9 * j)) & 511;
+			p.mask[bit >> 6] |= 1UL << (bit & 63);
+		}
+		return p;
+	}
+	inline void insert(ulong key) { insert(get_probe(key)); }
+	inline bool contains(ulong key) const { return contains(get_probe(key)); }
+	inline void insert(probe const& p) {
+		ulong* block = &bits[p.block * WORDS_PER_BLOCK];
+		for (int i = 0; i < WORDS_PER_BLOCK; i++) block[i] |= p.mask[i];
+	}
+	inline bool contains(probe const& p) const {
+		ulong const* block = &bits[p.block * WORDS_PER_BLOCK];
+		ulong missing = 0;
+		for (int i = 0; i < WORDS_PER_BLOCK; i++) missing |= p.mask[i] & ~block[i];
+		return missing == 0;
+	}
+	inline bool same_size(blocked_bloom_filter const& other) const { return num_blocks == other.num_blocks && num_hashes == other.num_hashes; }
+	inline ulong size() const { return num_blocks * WORDS_PER_BLOCK * 64; }
+	inline int get_num_hashes() const { return num_hashes; }
+	void clear();
+	void insert_all_keys();
+private:
+	static const int WORDS_PER_BLOCK = 8;
+	ulong num_blocks;
+	int num_hashes;
+	vector<ulong> bits;
+};
+
+// A count-min sketch of how often keys occur. Its size does not depend on the number of keys, and its estimates can only be
+// too high. A conservative update only raises the counters of a key that are at its estimate, which keeps the error low.
+// Halving the counters ages the counts, so they follow recent frequencies.
+class count_min_sketch {
+public:
+	count_min_sketch(int width = 1 << 14, int depth = 4);
+	inline uint estimate(ulong key) const {
+		uint min_count = UINT_MAX;
+		for (int row = 0; row < depth; row++) min_count = min(min_count, counters[get_index(key, row)]);
+		return min_count;
+	}
+	void add(ulong key);
+	void halve();
+	inline double get_total() const { return total; }
+	inline ulong get_size_in_bytes() const { return counters.size() * sizeof(uint); }
+private:
+	// Each row mixes the key with its own constant, so keys that collide in one row rarely collide in the others
+	inline ulong get_index(ulong key, int row) const {
+		ulong h = key + (row + 1) * 0x9E3779B97F4A7C15UL;
+		h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9UL;
+		h = (h ^ (h >> 27)) * 0x94D049BB133111EBUL;
+		return row * width + (((h >> 32) * width) >> 32);
+	}
+	int width, depth;
+	vector<uint> counters;
+	double total;
+};
+
 // BloomFilter hotness
-typedef vector< bloom_filter > hot_bloom_filter;
+typedef vector< blocked_bloom_filter > hot_bloom_filter;
 typedef vector< vector<uint> > lun_counters;
 
 
@@ -763,7 +880,7 @@ public:
 	uint writes;
 	int unique_wh_encountered;
 	int unique_wh_encountered_previous_window;
-	bloom_filter wh_counted_already;
+	blocked_bloom_filter wh_counted_already;
 
 	uint read_counter_window_size;
 	uint write_counter_window_size;
@@ -803,6 +920,27 @@ private:
 
 };
 
+// Counts reads and writes per page in two conservative-update Count-Min sketches, whose memory does not depend on the
+// size of the SSD. A count overestimates the true count by at most COUNT_MIN_EPSILON times the number of IOs counted,
+// with probability 1 - COUNT_MIN_DELTA. All counters are halved every COUNT_MIN_DECAY_INTERVAL IOs of their type, so old
+// IOs fade away. A page is hot if its count is at least COUNT_MIN_HOT_THRESHOLD times the mean count per logical page.
+class Count_Min_Page_Hotness_Measurer : public Page_Hotness_Measurer {
+public:
+	Count_Min_Page_Hotness_Measurer();
+	~Count_Min_Page_Hotness_Measurer() {};
+	void register_event(Event const& event);
+	enum write_hotness get_write_hotness(unsigned long page_address) const;
+	enum read_hotness get_read_hotness(unsigned long page_address) const;
+	Address get_best_target_die_for_WC(enum read_hotness rh) const;
+private:
+	bool is_hot(count_min_sketch const& s, ulong page_address) const;
+	count_min_sketch writes, reads;
+	int writes_since_decay, reads_since_decay;
+	int decay_interval;
+	vector<vector<double> > writes_per_die;
+	vector<vector<double> > reads_per_die;
+};
+
 class Random_Order_Iterator {
 public:
 	static vector<int> get_iterator(int needed_length);
@@ -812,6 +950,43 @@ private:
 	static MTRand_int32 random_number_generator;
 };
 
+// Visits every integer in [0, n) exactly once in a random order without allocating memory.
+// A counter over [0, 2^k), where 2^k is the smallest power of two not below n, is passed through a bijection made of
+// a few rounds of multiplying by a random odd number, adding a random number and xor-ing in the high bits.
+// Values of n or more are skipped. The bijection is drawn anew for every permutation.
+class Random_Permutation {
+public:
+	Random_Permutation(int n);
+	bool has_next() const { return remaining > 0; }
+	int next();
+private:
+	uint permute(uint x) const;
+	static const int NUM_ROUNDS = 3;
+	uint n;
+	uint mask;
+	uint shift;
+	uint multipliers[NUM_ROUNDS];
+	uint increments[NUM_ROUNDS];
+	uint counter;
+	int remaining;
+	static MTRand_int32 random_number_generator;
+};
+
+// A binary tree over a fixed number of keys in which every inner node holds the index of the smallest key beneath it.
+// Changing a key takes O(log n) and finding the smallest key takes O(1). Ties go to the lower index.
+class Tournament_Tree {
+public:
+	Tournament_Tree(int size = 0);
+	void update(int index, double key);
+	int get_min_index() const { return winners[1]; }
+	double get_min_key() const { return keys[winners[1]]; }
+	double get_key(int index) const { return keys[index]; }
+private:
+	int num_leaves;
+	vector<double> keys;
+	vector<int> winners;
+};
+
 class FtlParent
 {
 public:
@@ -906,6 +1081,7 @@ private:
 
 class ftl_cache {
 public:
+	ftl_cache(FtlImpl_Page* page_mapping = NULL);
 	void register_write_arrival(Event const&  app_write);
 	bool register_read_arrival(Event* app_read);
 	void register_write_completion(Event const& app_write);
@@ -917,27 +1093,46 @@ public:
 	int erase_victim(double time, bool allow_flushing_dirty);
 	bool contains(int key) const;
 	void set_synchronized(int key);
+	void set_page_mapping(FtlImpl_Page* new_page_mapping) { page_mapping = new_page_mapping; }
+	// The number of cache slots in use. This is what is compared against CACHED_ENTRIES_THRESHOLD.
+	long get_num_slots() const { return RANGE_COMPRESSION ? num_ranges : cached_mapping_table.size(); }
+	void print_stats() const;
 	static int CACHED_ENTRIES_THRESHOLD;
+	// If true, a run of cached entries with consecutive logical and physical addresses within
+	// the same translation page occupies a single cache slot, as in SFTL.
+	static bool RANGE_COMPRESSION;
 
 	struct entry {
-		entry() : dirty(false), synch_flag(false), fixed(false), hotness(0), timestamp(numeric_limits<double>::infinity()) {}
+		entry() : dirty(false), synch_flag(false), fixed(false), hotness(0), timestamp(numeric_limits<double>::infinity()), physical_address(UNDEFINED) {}
 		bool dirty;
 		bool synch_flag;
 		int fixed;
 		short hotness;
 		double timestamp; // when was the entry added to the cache
+		long physical_address; // only maintained with RANGE_COMPRESSION
 	};
 	unordered_map<long, entry> cached_mapping_table; // maps logical addresses to physical addresses
 	queue<long> eviction_queue_dirty;
 	queue<long> eviction_queue_clean;
 private:
 	void iterate(long& victim_key, entry& victim_entry, bool allow_choosing_dirty);
+	void insert(long key, entry const& e);
+	void erase(long key);
+	void set_physical_address(long key, long physical_address);
+	bool is_range_head(long key) const;
+	void unlink_from_ranges(long key);
+	void link_into_ranges(long key);
+	void cache_surrounding_range(long key);
+	void erase_clean_range(long key);
+	FtlImpl_Page* page_mapping;
+	long num_ranges;	// number of maximal runs of consecutive mappings in the cache
+	long num_hits, num_misses;
 };
 
 class flash_resident_page_ftl : public FtlParent {
 public:
 	flash_resident_page_ftl(Ssd *ssd, Block_manager_parent* bm) :
-		FtlParent(ssd, bm), cache(new ftl_cache()), page_mapping(new FtlImpl_Page(ssd, bm)), gc(NULL) {}
+		FtlParent(ssd, bm), cache(new ftl_cache()), page_mapping(new FtlImpl_Page(ssd, bm)), gc(NULL) { cache->set_page_mapping(page_mapping); }
 	flash_resident_page_ftl() : FtlParent(), gc(NULL), cache(new ftl_cache()), page_mapping(NULL) {}
 	ftl_cache* get_cache() { return cache; }
 	void set_gc(flash_resident_ftl_garbage_collection* new_gc) { gc = new_gc; }
@@ -970,6 +1165,13 @@ public:
 	void print_short() const;
 	static int ENTRIES_PER_TRANSLATION_PAGE;
 	static bool SEPERATE_MAPPING_PAGES;
+	// The number of translation pages to read ahead of a sequential read stream. 0 disables prefetching.
+	static int PREFETCH_DEPTH;
+	// The number of translation pages held in a Host Memory Buffer, a second mapping cache level in host RAM
+	// between the cached mapping table and flash. 0 disables the buffer.
+	static int HMB_TRANSLATION_PAGES;
+	// The PCIe round-trip time for fetching a translation page from the Host Memory Buffer
+	static double HMB_LATENCY;
 
 private:
 	void notify_garbage_collector(int translation_page_id, double time);
@@ -978,15 +1180,32 @@ private:
 	void create_mapping_read(long translation_page_id, double time, Event* dependant);
 	void mark_clean(long translation_page_id, Event const& event);
 	void try_clear_space_in_mapping_cache(double time);
+	void prefetch_translation_pages(long translation_page_id, double time);
+	void register_prefetch_hit(long translation_page_id);
+	bool lookup_host_memory_buffer(long translation_page_id, Event* event);
+	void insert_into_host_memory_buffer(long translation_page_id);
 	set<long> ongoing_mapping_operations; // contains the logical addresses of ongoing mapping IOs
+	set<long> prefetches_in_flight;	// translation page ids of ongoing prefetch mapping reads
+	deque<long> prefetch_buffer;	// translation page ids of the most recently prefetched translation pages, held in controller RAM
+	set<long> unused_prefetches;	// translation page ids that were prefetched but have not yet served a read
+	Sequential_Pattern_Detector* read_detector;
+	list<long> host_memory_buffer;	// translation page ids in the Host Memory Buffer, most recently used first
+	unordered_map<long, list<long>::iterator> host_memory_buffer_index;
 	unordered_map<long, vector<Event*> > application_ios_waiting_for_translation; // maps translation page ids to application IOs awaiting translation
 	struct mapping_page {
 		map<int, Address> entries;
 	};
 	vector<mapping_page> mapping_pages;
 	struct dftl_statistics {
+		dftl_statistics() : num_prefetches(0), num_useful_prefetches(0), num_prefetch_hits(0), num_demand_misses(0), num_hmb_hits(0), num_hmb_misses(0) {}
 		map<int, int> cleans_histogram;
 		map<int, int> address_hits;
+		long num_prefetches;		// prefetch mapping reads issued
+		long num_useful_prefetches;	// prefetched translation pages that served at least one read
+		long num_prefetch_hits;		// reads whose translation was provided by a prefetch
+		long num_demand_misses;		// reads that had to wait for a mapping read issued on demand
+		long num_hmb_hits;			// translation page lookups served from the Host Memory Buffer instead of flash
+		long num_hmb_misses;		// translation page lookups that missed the Host Memory Buffer and went to flash
 	};
 	dftl_statistics dftl_stats;
 };
@@ -1031,15 +1250,17 @@ private:
 	void consider_doing_garbage_collection(double time);
 
 	struct log_block {
-		log_block(Address& addr) : addr(addr), num_blocks_mapped_inside() {}
-		log_block() : addr(), num_blocks_mapped_inside() {}
+		log_block(Address& addr) : addr(addr), num_blocks_mapped_inside(), sequential(false) {}
+		log_block() : addr(), num_blocks_mapped_inside(), sequential(false) {}
 		Address addr;
 		set<int> num_blocks_mapped_inside;
+		bool sequential;	// every page so far was written at its own offset of a single logical block
 	    friend class boost::serialization::access;
 	    template<class Archive> void
 	    serialize(Archive & ar, const unsigned int version) {
 	    	ar & addr;
 	    	ar & num_blocks_mapped_inside;
+	    	ar & sequential;
 	    }
 	};
 
@@ -1056,17 +1277,168 @@ private:
 	priority_queue<log_block*, std::vector<log_block*>, mycomparison> full_log_blocks;
 	void release_events_there_was_no_space_for();
 	void garbage_collect(int block_id, log_block* log_block, double time);
+	bool partial_merge(int block_id, log_block* log_block, double time);
+	void issue_merge_migrations(int block_id, int first_page, double time);
 
 	vector<Address> translation_table;		  // maps block ID to a block address in flash. This is the main mapping table
 	map<int, log_block*> active_log_blocks_map;  // Maps a block ID to the address of the corresponding log block. Used to quickly determine where to place an update
 	int dial;
 	int NUM_LOG_BLOCKS;
 	int num_active_log_blocks;
-	map<int, queue<Event*> > queued_events; // stores events tar
+	vector<list<Event*> > queued_events;	// events waiting for a physical block, indexed by physical block ID
+	vector<bool> locked_blocks;				// true while an event is in flight on the physical block
+	queue<Event*> events_without_space;		// writes waiting for space in some log block
 	Migrator* migrator;
 	FtlImpl_Page page_mapping;
-	map<int, queue<Event*> > gc_queue;
-	map<long, queue<Event*> > logical_dependencies;  // a locking table with page granularity
+	vector<list<Event*> > gc_queue;			// pending merge reads and writes, indexed by logical block ID
+	vector<bool> being_merged;				// indexed by logical block ID
+	int num_blocks_being_merged;
+	long num_switch_merges;
+	long num_partial_merges;
+	long num_full_merges;
+};
+
+/* A host-managed zoned namespace (ZNS). The logical address space is split into zones of get_zone_size() pages.
+ * A zone must be written sequentially at its write pointer, either with normal writes or with zone appends,
+ * for which the device picks the address. A zone goes from empty to open on its first write and is full once
+ * its write pointer reaches the end. Writes elsewhere are rejected. A trim on any address of a zone resets the
+ * zone: its blocks are erased and it is empty again. There is no device garbage-collection.
+ * The pages of a zone are striped over BLOCKS_PER_ZONE blocks, which are allocated when first written. */
+class ZNS : public FtlParent {
+public:
+	ZNS(Ssd *ssd, Block_manager_parent* bm, Migrator* migrator);
+	~ZNS();
+	void read(Event *event);
+	void write(Event *event);
+	void trim(Event *event);
+	void register_write_completion(Event const& event, enum status result);
+	void register_read_completion(Event const& event, enum status result);
+	void register_trim_completion(Event & event);
+	void register_erase_completion(Event & event);
+	long get_logical_address(uint physical_address) const;
+	Address get_physical_address(uint logical_address) const;
+	void set_replace_address(Event& event) const;
+	void set_read_address(Event& event) const;
+	void print() const;
+	static int BLOCKS_PER_ZONE;
+	static inline long get_zone_size() { return BLOCKS_PER_ZONE * BLOCK_SIZE; }
+private:
+	enum zone_state { ZONE_EMPTY, ZONE_OPEN, ZONE_FULL };
+	struct zone_block {
+		zone_block() : addr(), busy(false), pending() {}
+		Address addr;			// next page to write in the block. NONE until the block is allocated
+		bool busy;				// a write to this block is in flight
+		queue<Event*> pending;	// writes waiting for the block, in write pointer order
+	};
+	struct zone {
+		zone() : state(ZONE_EMPTY), write_pointer(0), blocks(), reset(NULL) {}
+		zone_state state;
+		long write_pointer;
+		vector<zone_block> blocks;
+		Event* reset;			// a reset waiting for the writes in the zone to finish
+	};
+	void reject(Event* event);
+	bool allocate_block(int zone_id, int index, double time);
+	void dispatch(int zone_id, int index);
+	bool is_idle(zone const& z) const;
+	void reset_zone(int zone_id, double time);
+
+	vector<zone> zones;
+	vector<long> zone_of_block;		// maps a physical block ID to zone ID * BLOCKS_PER_ZONE + index in the zone
+	set<pair<int, int> > blocks_waiting_for_space;
+	Migrator* migrator;
+	long num_zone_resets;
+	long num_zone_appends;
+	long num_rejected_writes;
+	long num_unwritten_reads;
+};
+
+/* A DRAM write-back cache in the controller, sitting in front of the FTL. A host write completes as soon as it is in DRAM,
+ * and rewriting a page that has not reached flash yet is absorbed in DRAM. Dirty pages are destaged to the FTL in the
+ * background, see WRITE_CACHE_PAGES. Writes with force unit access bypass the cache, and a flush completes once all
+ * writes that arrived before it are in flash. A flush is a Message with the flush flag set. */
+class Write_Back_Cache
+{
+public:
+	Write_Back_Cache(FtlParent* ftl, IOScheduler* scheduler);
+	~Write_Back_Cache();
+	bool submit(Event* event);
+	bool register_event_completion(Event* event);
+	void drain(double time);
+	inline bool is_drained() const { return num_dirty_pages == 0 && destages_in_flight.empty(); }
+	inline bool is_enabled() const { return WRITE_CACHE_PAGES > 0; }
+private:
+	struct entry {
+		entry() : dirty(false), destaging(false), sequence_number(0), destage_sequence_number(0), position(), waiting() {}
+		bool dirty;
+		bool destaging;						// a destage write of the page is in flight
+		ulong sequence_number;				// when the page became dirty
+		ulong destage_sequence_number;		// when the page being destaged became dirty
+		list<long>::iterator position;		// in dirty_pages, unless the page is also being destaged
+		vector<Event*> waiting;				// IOs to the page that must wait until the destage is finished
+	};
+	void complete(Event* event, double delay);
+	void make_dirty(long lba, entry& e);
+	void drop_dirty(entry& e);
+	void hold(Event* event, entry& e);
+	void destage(double time);
+	bool should_destage();
+	void check_pending_flushes(double time);
+	void release(Event* event, double time);
+
+	FtlParent* ftl;
+	IOScheduler* scheduler;
+	unordered_map<long, entry> entries;
+	list<long> dirty_pages;							// dirty pages that may be destaged, least recently written first
+	long num_dirty_pages;
+	set<ulong> undurable;							// sequence numbers of dirty and destaging pages
+	ulong next_sequence_number;
+	unordered_map<uint, long> destages_in_flight;	// application IO ID to LBA
+	deque<pair<ulong, Event*> > pending_flushes;	// with the first sequence number that they need not wait for
+	int num_outstanding_host_ios;
+	bool destaging_to_low_watermark;
+	bool draining;									// all dirty pages are destaged, as before a power down
+	long num_host_writes, num_write_hits, num_absorbed_writes, num_bypassed_writes, num_destage_writes;
+	long num_host_reads, num_read_hits, num_flushes;
+};
+
+/* A DRAM read cache in the controller. Pages read from flash are kept in DRAM, and a read of a cached page completes
+ * after RAM_READ_DELAY and the data transfer, without touching flash. Host writes and trims invalidate the page, including
+ * a page whose flash read is still in flight. Pages are evicted with LRU or ARC, see READ_CACHE_POLICY. */
+class Read_Cache
+{
+public:
+	Read_Cache(IOScheduler* scheduler);
+	~Read_Cache();
+	bool submit(Event* event);
+	void invalidate(long lba);
+	void register_event_completion(Event const& event);
+	inline bool is_enabled() const { return READ_CACHE_PAGES > 0; }
+private:
+	// T1 and T2 hold cached pages seen once and more than once. B1 and B2 are ARC's ghost lists of pages evicted from them.
+	enum { T1, T2, B1, B2, NUM_LISTS };
+	struct location {
+		int which;
+		list<long>::iterator position;
+	};
+	struct read_in_flight {
+		read_in_flight() : count(0), stale(false) {}
+		int count;
+		bool stale;			// the page was written or trimmed after the read was issued
+	};
+	void insert(long lba);
+	void move_to(long lba, int to);
+	void remove(long lba);
+	void replace(bool in_b2);
+	inline long cached() const { return lists[T1].size() + lists[T2].size(); }
+
+	IOScheduler* scheduler;
+	list<long> lists[NUM_LISTS];		// most recently used first
+	unordered_map<long, location> locations;
+	long target_t1_size;				// ARC's adaptive target for T1
+	unordered_map<uint, long> misses_in_flight;		// application IO ID to LBA
+	unordered_map<long, read_in_flight> reads_in_flight;
+	long num_reads, num_hits, num_insertions, num_invalidations, num_evictions;
 };
 
 /* The SSD is the single main object that will be created to simulate a real
@@ -1096,6 +1468,7 @@ public:
     }
     IOScheduler* get_scheduler() { return scheduler; }
     void execute_all_remaining_events();
+    void drain_write_cache(double time);
 private:
     void submit_to_ftl(Event* event);
 	Package &get_data();
@@ -1104,6 +1477,8 @@ private:
 	OperatingSystem* os;
 	FtlParent *ftl;
 	IOScheduler *scheduler;
+	Write_Back_Cache *write_cache;
+	Read_Cache *read_cache;
 
 	struct io_map {
 		void resiger_large_event(Event* e);
@@ -1282,6 +1657,12 @@ public:
 	long num_gc_cancelled_not_enough_free_space;
 	long num_gc_cancelled_gc_already_happening;
 
+	// why GC was requested
+	long num_gc_triggered_out_of_space;		// fewer than a block's worth of free pages left in the SSD
+	long num_gc_triggered_write_blocked;	// an application write found no free page
+	long num_gc_triggered_low_free_blocks;	// a block allocation left a LUN short of free blocks
+	long num_gc_triggered_below_watermark;	// a LUN still below its watermark was asked again after an erase or a new GC candidate
+
 	long get_num_erases_executed() { return num_erases; }
 	static void set_record_statistics(bool val) { record_statistics = val; }
 	vector<vector<uint> > num_erases_per_LUN;
@@ -1520,6 +1901,18 @@ private:
 	double writes_probability;
 };
 
+// This workload starts with a large sequential write of the entire logical address space
+// After that a thread performs random writes with force unit access and flushes, see Flushing_Random_Writer
+class Flushing_Random_Workload : public Workload_Definition {
+public:
+	Flushing_Random_Workload(long num_writes, int fua_interval = 16, int flush_interval = 256);
+	vector<Thread*> generate();
+private:
+	long num_writes;
+	int fua_interval;
+	int flush_interval;
+};
+
 // This workload starts with a large sequential write of the entire logical address space
 // After that an asynchronous thread performs random writes across the logical address space
 class Init_Workload : public Workload_Definition {
@@ -1566,7 +1959,6 @@ public:
 	void run_single_point(string name);
 	static vector<Experiment_Result> random_writes_on_the_side_experiment(Workload_Definition* workload, int write_threads_min, int write_threads_max, int write_threads_inc, string name, int IO_limit, double used_space, int random_writes_min_lba, int random_writes_max_lba);
 	static Experiment_Result copyback_experiment(vector<Thread*> (*experiment)(int highest_lba), int used_space, int max_copybacks, string data_folder, string name, int IO_limit);
-	static Experiment_Result copyback_map_experiment(vector<Thread*> (*experiment)(int highest_lba), int cb_map_min, int cb_map_max, int cb_map_inc, int used_space, string data_folder, string name, int IO_limit);
 	void set_exponential_increase(bool e) { exponential_increase = e; }
 	void draw_graphs();
 	void draw_aggregate_graphs();
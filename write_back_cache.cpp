@@ -0,0 +1,256 @@
+/*
+ * write_back_cache.cpp
+ *
+ * The controller's DRAM write-back cache. Host writes complete once they are in DRAM, and dirty pages are destaged
+ * to the FTL in the background.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "ssd.h"
+
+using namespace ssd;
+
+Write_Back_Cache::Write_Back_Cache(FtlParent* ftl, IOScheduler* scheduler)
+:	ftl(ftl),
+	scheduler(scheduler),
+	entries(),
+	dirty_pages(),
+	num_dirty_pages(0),
+	undurable(),
+	next_sequence_number(0),
+	destages_in_flight(),
+	pending_flushes(),
+	num_outstanding_host_ios(0),
+	destaging_to_low_watermark(false),
+	draining(false),
+	num_host_writes(0),
+	num_write_hits(0),
+	num_absorbed_writes(0),
+	num_bypassed_writes(0),
+	num_destage_writes(0),
+	num_host_reads(0),
+	num_read_hits(0),
+	num_flushes(0)
+{}
+
+Write_Back_Cache::~Write_Back_Cache() {
+	if (!is_enabled()) {
+		return;
+	}
+	printf("write cache host writes\t%ld\n", num_host_writes);
+	printf("write cache write hits\t%ld\n", num_write_hits);
+	printf("write cache absorbed writes\t%ld\n", num_absorbed_writes);
+	printf("write cache bypassed writes\t%ld\n", num_bypassed_writes);
+	printf("write cache destage writes\t%ld\n", num_destage_writes);
+	printf("write cache dirty pages left\t%ld\n", num_dirty_pages);
+	printf("write cache read hits\t%ld\n", num_read_hits);
+	printf("write cache read hit rate\t%f\n", num_host_reads == 0 ? 0.0 : num_read_hits / (double)num_host_reads);
+	printf("write cache flushes\t%ld\n", num_flushes);
+}
+
+// Returns true if the cache has taken over the event, and false if it should go to the FTL
+bool Write_Back_Cache::submit(Event* event) {
+	if (!is_enabled()) {
+		return false;
+	}
+	double time = event->get_current_time();
+	num_outstanding_host_ios++;
+	if (event->is_flush()) {
+		num_flushes++;
+		pending_flushes.push_back(pair<ulong, Event*>(next_sequence_number, event));
+		check_pending_flushes(time);
+		destage(time);
+		return true;
+	}
+
+	event_type type = event->get_event_type();
+	long lba = event->get_logical_address();
+	auto it = entries.find(lba);
+	if (type == READ) {
+		num_host_reads++;
+		if (it != entries.end() && it->second.waiting.empty()) {
+			num_read_hits++;
+			complete(event, RAM_READ_DELAY);
+			return true;
+		}
+		return false;
+	}
+	if (type == WRITE) {
+		num_host_writes++;
+	}
+	if (type != WRITE && type != TRIM) {
+		return false;
+	}
+
+	// the IO must reach flash, and must not be overtaken by a destage of older data
+	if (type == TRIM || event->is_force_unit_access()) {
+		if (it == entries.end()) {
+			return false;
+		}
+		entry& e = it->second;
+		drop_dirty(e);
+		if (e.destaging) {
+			hold(event, e);
+			return true;
+		}
+		entries.erase(it);
+		return false;
+	}
+
+	if (it != entries.end()) {
+		entry& e = it->second;
+		num_write_hits++;
+		if (!e.waiting.empty()) {
+			hold(event, e);
+			return true;
+		}
+		if (e.dirty) {
+			num_absorbed_writes++;
+			if (!e.destaging) {
+				dirty_pages.splice(dirty_pages.end(), dirty_pages, e.position);
+			}
+		} else {
+			make_dirty(lba, e);
+		}
+	} else if ((int)entries.size() < WRITE_CACHE_PAGES) {
+		make_dirty(lba, entries[lba]);
+	} else {
+		num_bypassed_writes++;
+		return false;
+	}
+	complete(event, RAM_WRITE_DELAY);
+	destage(time);
+	return true;
+}
+
+// Returns true if the event was a destage write, which the cache has now dealt with
+bool Write_Back_Cache::register_event_completion(Event* event) {
+	if (!is_enabled()) {
+		return false;
+	}
+	double time = event->get_current_time();
+	auto it = destages_in_flight.find(event->get_application_io_id());
+	if (it == destages_in_flight.end() || it->second != event->get_logical_address() || event->get_event_type() != WRITE) {
+		if (event->is_original_application_io() && event->get_event_type() != READ_COMMAND) {
+			num_outstanding_host_ios--;
+			destage(time);
+		}
+		return false;
+	}
+	long lba = it->second;
+	destages_in_flight.erase(it);
+	entry& e = entries[lba];
+	assert(e.destaging);
+	e.destaging = false;
+	undurable.erase(e.destage_sequence_number);
+	vector<Event*> waiting;
+	waiting.swap(e.waiting);
+	if (e.dirty) {
+		e.position = dirty_pages.insert(dirty_pages.end(), lba);
+	} else {
+		entries.erase(lba);
+	}
+	for (auto held : waiting) {
+		release(held, time);
+	}
+	check_pending_flushes(time);
+	destage(time);
+	return true;
+}
+
+// Destages every dirty page, including pages written again while their destage is in flight, see Ssd::drain_write_cache
+void Write_Back_Cache::drain(double time) {
+	if (!is_enabled()) {
+		return;
+	}
+	draining = true;
+	destage(time);
+}
+
+void Write_Back_Cache::complete(Event* event, double delay) {
+	event->set_noop(true);
+	event->incr_execution_time(delay);
+	scheduler->schedule_event(event);
+}
+
+void Write_Back_Cache::make_dirty(long lba, entry& e) {
+	assert(!e.dirty);
+	e.dirty = true;
+	e.sequence_number = next_sequence_number++;
+	undurable.insert(e.sequence_number);
+	num_dirty_pages++;
+	if (!e.destaging) {
+		e.position = dirty_pages.insert(dirty_pages.end(), lba);
+	}
+}
+
+void Write_Back_Cache::drop_dirty(entry& e) {
+	if (!e.dirty) {
+		return;
+	}
+	e.dirty = false;
+	undurable.erase(e.sequence_number);
+	num_dirty_pages--;
+	if (!e.destaging) {
+		dirty_pages.erase(e.position);
+	}
+}
+
+// Later IOs to the page queue up behind the first held IO, so they reach the FTL in arrival order
+void Write_Back_Cache::hold(Event* event, entry& e) {
+	drop_dirty(e);
+	e.waiting.push_back(event);
+}
+
+// Dirty pages are destaged above the high watermark until the low watermark is reached, while the host is idle,
+// and while a flush is waiting. WRITE_CACHE_DESTAGE_BATCH bounds the number of destage writes in flight, and the
+// default of one per LUN lets the block manager spread a batch over all dies.
+void Write_Back_Cache::destage(double time) {
+	uint batch = WRITE_CACHE_DESTAGE_BATCH > 0 ? WRITE_CACHE_DESTAGE_BATCH : SSD_SIZE * PACKAGE_SIZE;
+	while (!dirty_pages.empty() && destages_in_flight.size() < batch && should_destage()) {
+		long lba = dirty_pages.front();
+		dirty_pages.pop_front();
+		entry& e = entries[lba];
+		e.dirty = false;
+		e.destaging = true;
+		e.destage_sequence_number = e.sequence_number;
+		num_dirty_pages--;
+		Event* write = new Event(WRITE, lba, 1, time);
+		write->set_original_application_io(true);
+		destages_in_flight[write->get_application_io_id()] = lba;
+		num_destage_writes++;
+		ftl->write(write);
+	}
+	// a drain is over once the last dirty page is on its way to flash
+	draining &= num_dirty_pages > 0;
+}
+
+bool Write_Back_Cache::should_destage() {
+	if (num_dirty_pages * 100 > (long)WRITE_CACHE_HIGH_WATERMARK * WRITE_CACHE_PAGES) {
+		destaging_to_low_watermark = true;
+	} else if (num_dirty_pages * 100 <= (long)WRITE_CACHE_LOW_WATERMARK * WRITE_CACHE_PAGES) {
+		destaging_to_low_watermark = false;
+	}
+	return destaging_to_low_watermark || draining || !pending_flushes.empty() || (WRITE_CACHE_IDLE_FLUSH && num_outstanding_host_ios == 0);
+}
+
+void Write_Back_Cache::check_pending_flushes(double time) {
+	while (!pending_flushes.empty() && (undurable.empty() || *undurable.begin() >= pending_flushes.front().first)) {
+		Event* flush = pending_flushes.front().second;
+		pending_flushes.pop_front();
+		flush->set_noop(true);
+		release(flush, time);
+	}
+}
+
+void Write_Back_Cache::release(Event* event, double time) {
+	double diff = time - event->get_current_time();
+	if (diff > 0) {
+		event->incr_accumulated_wait_time(diff);
+		event->incr_pure_ssd_wait_time(diff);
+	}
+	if (event->get_noop())				scheduler->schedule_event(event);
+	else if (event->get_event_type() == TRIM)	ftl->trim(event);
+	else								ftl->write(event);
+}